@@ -0,0 +1,384 @@
+#include <omp.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "symmetricMatrix.h"
+
+/*
+
+General Idea (Contraction Hierarchies):
+  - order the nodes by "importance", then contract them one by one from least to most important
+  - contracting a node removes it from the graph, but the shortest paths between the remaining nodes must survive
+    * for every pair of remaining neighbours (u, w), check if u -> node -> w is the only shortest path between them
+    * a "witness search" (a bounded Dijkstra from u that avoids the node) looks for a path that is at least as short
+    * if no witness is found, add a shortcut edge u -> w with the weight of the path through the node
+  - the importance (priority) of a node is its edge difference (shortcuts added - edges removed), plus the number of
+    neighbours that have already been contracted (this spreads the contraction out over the graph)
+  - priorities are updated lazily: pop the least important node, recompute its priority, and only contract it if it is still the least important
+  - when a node is contracted, all its remaining neighbours are more important than it, so its edges at that moment are its "upward" edges
+  - the index stores the contraction order and the upward edges of every node, which is all that a query needs
+
+  - our graphs are dense, and most of their edges are never part of any shortest path, so we remove those first:
+    * run a full Dijkstra from a few landmark nodes (in parallel)
+    * if d(u, L) + d(L, w) < weight(u, w) for some landmark L, there is a strictly shorter path, so the edge (u, w) is redundant
+  - the witness searches from each neighbour of a node are independent of each other, so they run in parallel (OpenMP)
+
+*/
+
+const std::string inputPath = "graphs/";
+const std::string indexPath = "ch-index/";
+
+// number of landmarks used to find redundant edges
+const int numLandmarks = 16;
+
+// stop a witness search after this many nodes have been settled - a failed search only adds an unnecessary shortcut
+const int witnessSettleLimit = 128;
+
+typedef struct {
+  int from;
+  int to;
+  int weight;
+} shortcut;
+
+// the remaining (uncontracted) graph: for each node, a map of neighbour -> edge weight
+std::vector<std::unordered_map<int, int>> graph;
+
+// a bounded Dijkstra search, reused between searches (only the touched entries are reset)
+class WitnessSearch {
+ public:
+  void resize(const int numNodes) {
+    distance.assign(numNodes, INT32_MAX);
+  }
+
+  // search from the source, never passing through the excluded node or exceeding the max distance
+  void run(const int source, const int excluded, const int maxDistance) {
+    typedef std::pair<int, int> entry;  // (distance, node)
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+
+    setDistance(source, 0);
+    queue.push(entry(0, source));
+
+    int settled = 0;
+    while (!queue.empty() && settled < witnessSettleLimit) {
+      entry top = queue.top();
+      queue.pop();
+
+      // stale queue entry
+      if (top.first > distance[top.second]) continue;
+
+      // nothing further away can be a witness
+      if (top.first > maxDistance) break;
+
+      settled++;
+      for (const auto &edge : graph[top.second]) {
+        if (edge.first == excluded) continue;
+
+        int newDistance = top.first + edge.second;
+        if (newDistance < distance[edge.first]) {
+          setDistance(edge.first, newDistance);
+          queue.push(entry(newDistance, edge.first));
+        }
+      }
+    }
+  }
+
+  int distanceTo(const int node) const {
+    return distance[node];
+  }
+
+  // clear only the entries this search wrote to
+  void reset() {
+    for (int node : touched) distance[node] = INT32_MAX;
+    touched.clear();
+  }
+
+ private:
+  std::vector<int> distance;
+  std::vector<int> touched;
+
+  void setDistance(const int node, const int value) {
+    if (distance[node] == INT32_MAX) touched.push_back(node);
+    distance[node] = value;
+  }
+};
+
+// find the shortcuts needed between the neighbour at position a and every later neighbour, if node is contracted
+void findShortcuts(const int node, const std::vector<std::pair<int, int>> &neighbours, const int a, WitnessSearch &search,
+                   std::vector<shortcut> &shortcuts) {
+  // the longest path through the node that starts at this neighbour
+  int maxVia = 0;
+  for (int b = a + 1; b < neighbours.size(); b++) {
+    maxVia = std::max(maxVia, neighbours[a].second + neighbours[b].second);
+  }
+  if (maxVia == 0) return;
+
+  search.run(neighbours[a].first, node, maxVia);
+
+  for (int b = a + 1; b < neighbours.size(); b++) {
+    int via = neighbours[a].second + neighbours[b].second;
+
+    // no path avoiding the node is as short - need a shortcut
+    if (search.distanceTo(neighbours[b].first) > via) {
+      shortcuts.push_back({neighbours[a].first, neighbours[b].first, via});
+    }
+  }
+
+  search.reset();
+}
+
+// get the neighbours of a node in the remaining graph
+std::vector<std::pair<int, int>> getNeighbours(const int node) {
+  return std::vector<std::pair<int, int>>(graph[node].begin(), graph[node].end());
+}
+
+// simulate the contraction of a node using a single thread (used when many nodes are evaluated in parallel)
+void simulateContraction(const int node, WitnessSearch &search, std::vector<shortcut> &shortcuts) {
+  std::vector<std::pair<int, int>> neighbours = getNeighbours(node);
+  for (int a = 0; a < neighbours.size(); a++) {
+    findShortcuts(node, neighbours, a, search, shortcuts);
+  }
+}
+
+// simulate the contraction of a node, running the witness search from each neighbour in parallel
+void simulateContractionParallel(const int node, std::vector<WitnessSearch> &searches, std::vector<shortcut> &shortcuts) {
+  std::vector<std::pair<int, int>> neighbours = getNeighbours(node);
+
+#pragma omp parallel shared(node, neighbours, searches, shortcuts) default(none)
+  {
+    std::vector<shortcut> localShortcuts;
+    WitnessSearch &search = searches[omp_get_thread_num()];
+
+#pragma omp for schedule(dynamic)
+    for (int a = 0; a < neighbours.size(); a++) {
+      findShortcuts(node, neighbours, a, search, localShortcuts);
+    }
+
+#pragma omp critical
+    shortcuts.insert(shortcuts.end(), localShortcuts.begin(), localShortcuts.end());
+  }
+}
+
+// find the distance from the source to every node in the (full) graph
+void landmarkDijkstra(const int source, std::vector<int> &distance) {
+  typedef std::pair<int, int> entry;  // (distance, node)
+  std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+
+  distance.assign(graph.size(), INT32_MAX);
+  distance[source] = 0;
+  queue.push(entry(0, source));
+
+  while (!queue.empty()) {
+    entry top = queue.top();
+    queue.pop();
+
+    // stale queue entry
+    if (top.first > distance[top.second]) continue;
+
+    for (const auto &edge : graph[top.second]) {
+      int newDistance = top.first + edge.second;
+      if (newDistance < distance[edge.first]) {
+        distance[edge.first] = newDistance;
+        queue.push(entry(newDistance, edge.first));
+      }
+    }
+  }
+}
+
+// remove every edge that a landmark proves has a strictly shorter alternative path
+long long removeRedundantEdges() {
+  const int totalNodes = graph.size();
+  const int landmarks = std::min(numLandmarks, totalNodes);
+
+  // distances from each landmark (spread evenly through the node numbers)
+  std::vector<std::vector<int>> landmarkDistance(landmarks);
+
+#pragma omp parallel for schedule(dynamic) shared(landmarks, totalNodes, landmarkDistance) default(none)
+  for (int l = 0; l < landmarks; l++) {
+    landmarkDijkstra((long long)l * totalNodes / landmarks, landmarkDistance[l]);
+  }
+
+  long long removed = 0;
+
+  // the test is symmetric, so each thread only needs to erase from the maps of its own nodes
+#pragma omp parallel for schedule(dynamic, 16) reduction(+ : removed) shared(landmarks, totalNodes, landmarkDistance, graph) default(none)
+  for (int u = 0; u < totalNodes; u++) {
+    std::vector<int> redundant;
+    for (const auto &edge : graph[u]) {
+      for (int l = 0; l < landmarks; l++) {
+        if ((long long)landmarkDistance[l][u] + landmarkDistance[l][edge.first] < edge.second) {
+          redundant.push_back(edge.first);
+          break;
+        }
+      }
+    }
+
+    for (int w : redundant) graph[u].erase(w);
+    removed += redundant.size();
+  }
+
+  // each edge was removed from both of its endpoints
+  return removed / 2;
+}
+
+// edge difference, plus the number of contracted neighbours
+int computePriority(const int node, const int numShortcuts, const std::vector<int> &contractedNeighbours) {
+  return numShortcuts - (int)graph[node].size() + contractedNeighbours[node];
+}
+
+// add (or shorten) an undirected edge in the remaining graph
+void addEdge(const int from, const int to, const int weight) {
+  auto it = graph[from].find(to);
+  if (it == graph[from].end() || weight < it->second) {
+    graph[from][to] = weight;
+    graph[to][from] = weight;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    std::cout << "Usage: " << argv[0] << " <graph filename>" << std::endl;
+    return 0;
+  }
+
+  // get the command line arguments
+  std::string filename(argv[1]);
+
+  // read in the graph from the file
+  std::ifstream GraphIn(inputPath + filename);
+
+  // only the upper triangle is stored - it is only read row by row above the diagonal, which is contiguous
+  SymmetricMatrix adjacencyMatrix;
+  int totalNodes = readGraph(GraphIn, adjacencyMatrix, true);
+
+  // only the edges are kept
+  graph.resize(totalNodes);
+  long long numEdges = 0;
+  for (int row = 0; row < totalNodes; row++) {
+    const int *upper = adjacencyMatrix.upperRow(row);
+    for (int col = row + 1; col < totalNodes; col++) {
+      int weight = upper[col - row - 1];
+      if (weight != 0) {
+        graph[row][col] = weight;
+        graph[col][row] = weight;
+        numEdges++;
+      }
+    }
+  }
+  adjacencyMatrix = SymmetricMatrix();
+
+  // close the input file
+  GraphIn.close();
+
+  auto startTime = std::chrono::high_resolution_clock::now();
+
+  // ------------------ redundant edge removal ------------------
+  long long numRedundant = removeRedundantEdges();
+
+  // one witness search per thread
+  std::vector<WitnessSearch> searches(omp_get_max_threads());
+  for (WitnessSearch &search : searches) search.resize(totalNodes);
+
+  // ------------------ initial node ordering ------------------
+  std::vector<int> contractedNeighbours(totalNodes, 0);
+  std::vector<int> priority(totalNodes, 0);
+
+#pragma omp parallel shared(totalNodes, searches, priority, contractedNeighbours) default(none)
+  {
+    WitnessSearch &search = searches[omp_get_thread_num()];
+    std::vector<shortcut> shortcuts;
+
+#pragma omp for schedule(dynamic, 16)
+    for (int node = 0; node < totalNodes; node++) {
+      shortcuts.clear();
+      simulateContraction(node, search, shortcuts);
+      priority[node] = computePriority(node, shortcuts.size(), contractedNeighbours);
+    }
+  }
+
+  typedef std::pair<int, int> entry;  // (priority, node)
+  std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+  for (int node = 0; node < totalNodes; node++) {
+    queue.push(entry(priority[node], node));
+  }
+
+  // ------------------ contraction ------------------
+  std::vector<int> order(totalNodes, -1);
+  std::vector<std::vector<std::pair<int, int>>> upward(totalNodes);
+  long long numShortcuts = 0;
+  int nextOrder = 0;
+
+  while (!queue.empty()) {
+    int node = queue.top().second;
+    queue.pop();
+
+    // lazy update - recompute the priority, and postpone the node if it is no longer the least important
+    std::vector<shortcut> shortcuts;
+    simulateContractionParallel(node, searches, shortcuts);
+    int newPriority = computePriority(node, shortcuts.size(), contractedNeighbours);
+    if (!queue.empty() && newPriority > queue.top().first) {
+      queue.push(entry(newPriority, node));
+      continue;
+    }
+
+    // contract the node - its remaining edges all lead to more important nodes
+    order[node] = nextOrder++;
+    upward[node] = getNeighbours(node);
+
+    for (const auto &edge : upward[node]) {
+      graph[edge.first].erase(node);
+      contractedNeighbours[edge.first]++;
+    }
+    graph[node].clear();
+
+    for (const shortcut &s : shortcuts) {
+      addEdge(s.from, s.to, s.weight);
+    }
+    numShortcuts += shortcuts.size();
+  }
+
+  auto endTime = std::chrono::high_resolution_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
+
+  // ------------------ write the index ------------------
+  // format (binary): totalNodes, numUpwardEdges, order[totalNodes], offsets[totalNodes + 1], targets[numUpwardEdges], weights[numUpwardEdges]
+  std::vector<int> offsets(totalNodes + 1, 0);
+  for (int node = 0; node < totalNodes; node++) {
+    offsets[node + 1] = offsets[node] + upward[node].size();
+  }
+  int numUpwardEdges = offsets[totalNodes];
+
+  std::vector<int> targets, weights;
+  targets.reserve(numUpwardEdges);
+  weights.reserve(numUpwardEdges);
+  for (int node = 0; node < totalNodes; node++) {
+    for (const auto &edge : upward[node]) {
+      targets.push_back(edge.first);
+      weights.push_back(edge.second);
+    }
+  }
+
+  std::ofstream IndexOut(indexPath + filename + ".ch", std::ios::binary);
+  IndexOut.write((const char *)&totalNodes, sizeof(int));
+  IndexOut.write((const char *)&numUpwardEdges, sizeof(int));
+  IndexOut.write((const char *)order.data(), order.size() * sizeof(int));
+  IndexOut.write((const char *)offsets.data(), offsets.size() * sizeof(int));
+  IndexOut.write((const char *)targets.data(), targets.size() * sizeof(int));
+  IndexOut.write((const char *)weights.data(), weights.size() * sizeof(int));
+  long long indexSize = IndexOut.tellp();
+  IndexOut.close();
+
+  std::cout << "CH preprocessing time: " << duration.count() << "ms" << std::endl;
+  std::cout << "CH redundant edges removed: " << numRedundant << std::endl;
+  std::cout << "CH shortcuts added: " << numShortcuts << " (original edges: " << numEdges << ")" << std::endl;
+  std::cout << "CH index size: " << indexSize << " bytes" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,190 @@
+#include <stdlib.h>
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <queue>
+#include <utility>
+#include <vector>
+
+/*
+
+General Idea (Contraction Hierarchy query):
+  - load the index built by chPreprocess (contraction order and upward edges of every node)
+  - a point-to-point query runs two Dijkstra searches that only follow upward edges:
+    * a forward search from the source, and a backward search from the target (the graph is undirected, so both use the same edges)
+    * every shortest path has a most important node, and both searches reach it going only upward
+  - the best meeting node (minimum forward + backward distance) gives the shortest path length
+  - a search direction can stop once its smallest queued distance is not smaller than the best path found so far
+
+  - to compare against the serial output, we answer one query from the start node to every other node
+
+*/
+
+const std::string indexPath = "ch-index/";
+const std::string outputPath = "ch-output/";
+
+int totalNodes;
+std::vector<int> offsets, targets, weights;
+
+typedef std::pair<int, int> entry;  // (distance, node)
+typedef std::priority_queue<entry, std::vector<entry>, std::greater<entry>> minQueue;
+
+// one direction of the bidirectional search, reused between queries (only the touched entries are reset)
+class UpwardSearch {
+ public:
+  minQueue queue;
+
+  void resize(const int numNodes) {
+    distance.assign(numNodes, INT32_MAX);
+  }
+
+  void start(const int source) {
+    setDistance(source, 0);
+    queue.push(entry(0, source));
+  }
+
+  int minQueued() const {
+    return queue.empty() ? INT32_MAX : queue.top().first;
+  }
+
+  int distanceTo(const int node) const {
+    return distance[node];
+  }
+
+  // settle the next node, and return it (or -1 if the queue entry was stale)
+  int step() {
+    entry top = queue.top();
+    queue.pop();
+
+    if (top.first > distance[top.second]) return -1;
+
+    for (int e = offsets[top.second]; e < offsets[top.second + 1]; e++) {
+      int newDistance = top.first + weights[e];
+      if (newDistance < distance[targets[e]]) {
+        setDistance(targets[e], newDistance);
+        queue.push(entry(newDistance, targets[e]));
+      }
+    }
+
+    return top.second;
+  }
+
+  void reset() {
+    for (int node : touched) distance[node] = INT32_MAX;
+    touched.clear();
+    queue = minQueue();
+  }
+
+ private:
+  std::vector<int> distance;
+  std::vector<int> touched;
+
+  void setDistance(const int node, const int value) {
+    if (distance[node] == INT32_MAX) touched.push_back(node);
+    distance[node] = value;
+  }
+};
+
+// find the shortest path length between the source and the target
+int query(const int source, const int target, UpwardSearch &forward, UpwardSearch &backward) {
+  if (source == target) return 0;
+
+  forward.start(source);
+  backward.start(target);
+
+  int best = INT32_MAX;
+  while (std::min(forward.minQueued(), backward.minQueued()) < best) {
+    // advance the direction with the smaller queued distance
+    bool goForward = forward.minQueued() <= backward.minQueued();
+    UpwardSearch &current = goForward ? forward : backward;
+    UpwardSearch &other = goForward ? backward : forward;
+
+    int node = current.step();
+    if (node != -1 && other.distanceTo(node) != INT32_MAX) {
+      // the two searches meet at this node
+      best = std::min(best, current.distanceTo(node) + other.distanceTo(node));
+    }
+  }
+
+  forward.reset();
+  backward.reset();
+
+  return best;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cout << "Usage: " << argv[0] << " <graph filename> <start node>" << std::endl;
+    return 0;
+  }
+
+  // get the command line arguments
+  std::string filename(argv[1]);
+  const int startNode = atoi(argv[2]);
+
+  // read in the index
+  std::ifstream IndexIn(indexPath + filename + ".ch", std::ios::binary);
+  if (!IndexIn) {
+    std::cout << "Could not open the index - run chPreprocess on " << filename << " first" << std::endl;
+    return 0;
+  }
+
+  auto loadStart = std::chrono::high_resolution_clock::now();
+
+  int numUpwardEdges;
+  IndexIn.read((char *)&totalNodes, sizeof(int));
+  IndexIn.read((char *)&numUpwardEdges, sizeof(int));
+
+  // if the start vertex is >= than the number of vertices, throw error
+  if (startNode < 0 || startNode >= totalNodes) {
+    std::cout << "Please choose a valid start vertex (i.e. a value between 0 and " << totalNodes - 1 << ", inclusive)" << std::endl;
+    IndexIn.close();
+    return 0;
+  }
+
+  // the contraction order is not needed to query - upward edges already encode it
+  IndexIn.seekg(totalNodes * sizeof(int), std::ios::cur);
+
+  offsets.resize(totalNodes + 1);
+  targets.resize(numUpwardEdges);
+  weights.resize(numUpwardEdges);
+  IndexIn.read((char *)offsets.data(), offsets.size() * sizeof(int));
+  IndexIn.read((char *)targets.data(), targets.size() * sizeof(int));
+  IndexIn.read((char *)weights.data(), weights.size() * sizeof(int));
+  IndexIn.close();
+
+  auto loadEnd = std::chrono::high_resolution_clock::now();
+
+  UpwardSearch forward, backward;
+  forward.resize(totalNodes);
+  backward.resize(totalNodes);
+
+  // answer a query from the start node to every node
+  std::vector<int> distanceArray(totalNodes);
+
+  auto startTime = std::chrono::high_resolution_clock::now();
+  for (int target = 0; target < totalNodes; target++) {
+    distanceArray[target] = query(startNode, target, forward, backward);
+  }
+  auto endTime = std::chrono::high_resolution_clock::now();
+
+  auto loadDuration = std::chrono::duration_cast<std::chrono::milliseconds>(loadEnd - loadStart);
+  auto queryDuration = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime);
+
+  std::cout << "CH index load time: " << loadDuration.count() << "ms" << std::endl;
+  std::cout << "CH average query time: " << (double)queryDuration.count() / totalNodes / 1000 << "us" << std::endl;
+
+  // print result to file
+  std::ofstream GraphOut(outputPath + std::to_string(startNode) + "-" + filename);
+
+  for (int value : distanceArray) {
+    GraphOut << value << "\n";
+  }
+
+  // close the output file
+  GraphOut.close();
+
+  return 0;
+}
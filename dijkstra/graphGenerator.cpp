@@ -10,6 +10,8 @@
 #include <unordered_set>
 #include <vector>
 
+#include "symmetricMatrix.h"
+
 using namespace std;
 
 const int minNum = 1;
@@ -36,7 +38,7 @@ int getRandomElement(unordered_set<int> &theSet, bool removeElement) {
 }
 
 // generate a spanning tree between the vertices - will make a graph connected
-void generateSpanningTree(const int numVertices, vector<vector<int>> &adjacencyMatrix) {
+void generateSpanningTree(const int numVertices, SymmetricMatrix &adjacencyMatrix) {
   // have sets of connected and unconnected nodes
   unordered_set<int> connected, unconnected;
   connected.insert(0);  // first node is trivially connected
@@ -52,8 +54,8 @@ void generateSpanningTree(const int numVertices, vector<vector<int>> &adjacencyM
     int unconnectedNode = getRandomElement(unconnected, true);
 
     // connect these two elements
-    adjacencyMatrix[connectedNode][unconnectedNode] = rand() % (maxNum - minNum + 1) + minNum;
-    adjacencyMatrix[unconnectedNode][connectedNode] = adjacencyMatrix[connectedNode][unconnectedNode];
+    // (the matrix is symmetrical, so this sets both directions)
+    adjacencyMatrix.set(connectedNode, unconnectedNode, rand() % (maxNum - minNum + 1) + minNum);
 
     // insert the now-connected node into the connected set
     connected.insert(unconnectedNode);
@@ -81,7 +83,7 @@ void generateSpanningTree(const int numVertices, vector<vector<int>> &adjacencyM
 
 // generate a random undirected and connected graph
 // return an adjacency matrix
-void generateRandomGraph(const int numVertices, const double probability, vector<vector<int>> &adjacencyMatrix) {
+void generateRandomGraph(const int numVertices, const double probability, SymmetricMatrix &adjacencyMatrix) {
   // start by generating a random spanning tree through the nodes - this will make it connected
   // then assign extra edges
   generateSpanningTree(numVertices, adjacencyMatrix);
@@ -90,20 +92,17 @@ void generateRandomGraph(const int numVertices, const double probability, vector
   // loop through each columns after the main diagonal (undirected graph, so the matrix will be symmetrical)
   // randomly assign a weight
   for (int row = 0; row < adjacencyMatrix.size(); row++) {
-    for (int col = row + 1; col < adjacencyMatrix[row].size(); col++) {
+    for (int col = row + 1; col < adjacencyMatrix.size(); col++) {
       // assign a weight with the given probability
-      if (adjacencyMatrix[row][col] == 0 && (double)rand() / RAND_MAX < probability) {
-        // assign the weight
-        adjacencyMatrix[row][col] = rand() % (maxNum - minNum + 1) + minNum;
-
-        // make the matrix symmetrical
-        adjacencyMatrix[col][row] = adjacencyMatrix[row][col];
+      if (adjacencyMatrix.at(row, col) == 0 && (double)rand() / RAND_MAX < probability) {
+        // assign the weight (only the upper triangle is stored, so the matrix is symmetrical)
+        adjacencyMatrix.set(row, col, rand() % (maxNum - minNum + 1) + minNum);
       }
     }
   }
 }
 
-void toString(vector<vector<int>> &adjacencyMatrix) {
+void toString(SymmetricMatrix &adjacencyMatrix) {
   // print out the vertiex numbers
   for (int i = 0; i < adjacencyMatrix.size(); i++) {
     cout << i << endl;
@@ -111,9 +110,9 @@ void toString(vector<vector<int>> &adjacencyMatrix) {
 
   // print out the edges
   for (int row = 0; row < adjacencyMatrix.size(); row++) {
-    for (int col = row + 1; col < adjacencyMatrix[row].size(); col++) {
+    for (int col = row + 1; col < adjacencyMatrix.size(); col++) {
       // assign a weight with the given probability
-      if (adjacencyMatrix[row][col] != 0) {
+      if (adjacencyMatrix.at(row, col) != 0) {
         cout << row << " " << col << endl;
       }
     }
@@ -121,8 +120,8 @@ void toString(vector<vector<int>> &adjacencyMatrix) {
 }
 
 int main(int argc, char *argv[]) {
-  if (argc != 4) {
-    cout << "Usage: " << argv[0] << " <number of vertices> <probability of edge appearing> <output filename>" << endl;
+  if (argc != 4 && argc != 5) {
+    cout << "Usage: " << argv[0] << " <number of vertices> <probability of edge appearing> <output filename> <OPTIONAL: upper>" << endl;
     return 0;
   }
 
@@ -130,8 +129,12 @@ int main(int argc, char *argv[]) {
   const double probability = atof(argv[2]);
   string filename(argv[3]);
 
-  // create the adjacency matrix
-  vector<vector<int>> adjacencyMatrix(numVertices, vector<int>(numVertices, 0));
+  // only write the upper triangle (the matrix is symmetrical, so this halves the file)
+  const bool upperOnly = argc == 5 && string(argv[4]) == "upper";
+
+  // create the adjacency matrix (only the upper triangle is stored - nothing here reads whole rows, so it costs no speed)
+  SymmetricMatrix adjacencyMatrix;
+  adjacencyMatrix.resize(numVertices, true);
 
   // generate the random graph
   srand(time(0));
@@ -141,17 +144,23 @@ int main(int argc, char *argv[]) {
   // write the graph to the text file
   ofstream Graph(filepath + filename);
 
-  Graph << "Density: " << probability << "\n"
+  Graph << "Density: " << probability;
+  if (upperOnly) {
+    Graph << " " << upperTriangleTag;
+  }
+  Graph << "\n"
         << numVertices << "\n";
 
-  for (int i = 0; i < adjacencyMatrix.size(); i++) {
-    for (int j = 0; j < adjacencyMatrix[i].size(); j++) {
-      Graph << adjacencyMatrix[i][j];
-      if (j != adjacencyMatrix[i].size() - 1) {
+  // the upper triangle has no entries in the last row
+  const int numRows = upperOnly ? numVertices - 1 : numVertices;
+  for (int i = 0; i < numRows; i++) {
+    for (int j = upperOnly ? i + 1 : 0; j < numVertices; j++) {
+      Graph << adjacencyMatrix.at(i, j);
+      if (j != numVertices - 1) {
         Graph << " ";
       }
     }
-    if (i != adjacencyMatrix.size() - 1) {
+    if (i != numRows - 1) {
       Graph << "\n";
     }
   }
@@ -5,9 +5,12 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <unordered_set>
 #include <vector>
 
+#include "symmetricMatrix.h"
+
 const int averageIterations = 5;
 const std::string inputPath = "graphs/";
 const std::string outputPath = "mpi-output/";
@@ -16,6 +19,16 @@ int totalNodes;
 int rank;
 int numProcs;
 
+// every process on a node reads the graph in place from one shared memory window
+bool sharedGraph = false;
+
+// the graph is held as a packed upper triangle (half the memory, slower rows) instead of a full matrix
+bool packedGraph = false;
+
+// bytes of graph data held by this process, and the time spent distributing the graph (microseconds, summed over iterations)
+size_t graphBytes = 0;
+u_int64_t distributionTime = 0;
+
 typedef struct {
   int node;      // global node number
   int distance;  // min distance to this node
@@ -62,16 +75,29 @@ int convertToGlobalNode(const int nodeDisplacement) {
   return localNodes * rank + nodeDisplacement;
 }
 
-// determine the node displacement in this process of the global node
+// determine the node displacement in this process of the global node (every process starts at the same multiple of the
+// ordinary number of nodes - the last process only differs in how many it has)
 int convertToLocalNode(const int globalNode) {
+  return globalNode - convertToGlobalNode(0);
+}
+
+// determine the process that owns a global node - the last process owns any extras
+int determineOwner(const int globalNode) {
+  return std::min(globalNode / determineNumLocalNodes(), numProcs - 1);
+}
+
+// determine the number of nodes (rows) of each process, and the first node of each process
+void determineDistribution(int *counts, int *displs) {
   int localNodes = determineNumLocalNodes();
+  int lastNodes = totalNodes - localNodes * (numProcs - 1);
 
-  if (rank == numProcs - 1) {
-    // last process - special number of nodes
-    localNodes = totalNodes - localNodes * (numProcs - 1);
+  displs[0] = 0;
+  counts[0] = localNodes;
+  for (int i = 1; i < numProcs; i++) {
+    counts[i] = localNodes;
+    displs[i] = displs[i - 1] + localNodes;
   }
-
-  return globalNode % localNodes;
+  counts[numProcs - 1] = lastNodes;
 }
 
 // check that two arrays are equal
@@ -147,8 +173,27 @@ node_distance pickShortestUnvisitedNode(const std::unordered_set<int> &terminalN
   return minNode;
 }
 
+// a process's rows, copied into its own dense block (local row, global column)
+struct BlockWeights {
+  const std::vector<int> &localMatrix;
+
+  int operator()(const int localNode, const int globalNode) const {
+    return localMatrix[convertToIndex(localNode, globalNode)];
+  }
+};
+
+// a process's rows, read in place from the node's shared matrix
+struct SharedWeights {
+  const SymmetricMatrix &adjacencyMatrix;
+
+  int operator()(const int localNode, const int globalNode) const {
+    return adjacencyMatrix.at(convertToGlobalNode(localNode), globalNode);
+  }
+};
+
 // run parallel dijsktra
-void dijsktra(const int startNode, std::vector<int> &localMatrix, std::vector<int> &distanceArray) {
+template <typename Weights>
+void dijsktra(const int startNode, const Weights &weight, std::vector<int> &distanceArray) {
   // a set of nodes that we know the shortest path to
   std::unordered_set<int> terminalNodes;
 
@@ -172,18 +217,19 @@ void dijsktra(const int startNode, std::vector<int> &localMatrix, std::vector<in
     // loop through all its local neighbours
     for (int i = 0; i < distanceArray.size(); i++) {
       // if an edge exists between the two nodes
-      if (localMatrix[convertToIndex(i, globalNode.node)] != 0) {
+      int edgeWeight = weight(i, globalNode.node);
+      if (edgeWeight != 0) {
         // if we have not yet closed this neighbour
         if (terminalNodes.find(convertToGlobalNode(i)) == terminalNodes.end()) {
           // then we can update its length, if it is required
-          distanceArray[i] = std::min(distanceArray[i], globalNode.distance + localMatrix[convertToIndex(i, globalNode.node)]);
+          distanceArray[i] = std::min(distanceArray[i], globalNode.distance + edgeWeight);
         }
       }
     }
   }
 }
 
-void doWork(const int startNode, std::vector<int> &adjacencyMatrix, std::vector<int> &distanceArray) {
+void doWork(const int startNode, const SymmetricMatrix &adjacencyMatrix, std::vector<int> &distanceArray) {
   // ------------------ distribute nodes (rows of adjacency matrix) ------------------
 
   // define a new datatype (of rows)
@@ -191,38 +237,50 @@ void doWork(const int startNode, std::vector<int> &adjacencyMatrix, std::vector<
   MPI_Type_contiguous(totalNodes, MPI_INT, &ROW);
   MPI_Type_commit(&ROW);
 
-  // determine the number of nodes per process - last process makes up the deficit
-  int localNodes = determineNumLocalNodes();
-  int lastNodes = totalNodes - localNodes * (numProcs - 1);
-
   // determine the number of rows to send to each process, and the offset in the matrix
+  // the last process makes up the deficit
   int sendcounts[numProcs];
   int displs[numProcs];
-  displs[0] = 0;
-  sendcounts[0] = localNodes;
-  for (int i = 1; i < numProcs; i++) {
-    sendcounts[i] = localNodes;
-    displs[i] = displs[i - 1] + localNodes;
-  }
-  sendcounts[numProcs - 1] = lastNodes;
+  determineDistribution(sendcounts, displs);
+  int localNodes = sendcounts[rank];
 
-  // the last process picks up any straggler rows
-  if (rank == numProcs - 1) {
-    localNodes = lastNodes;
-  }
+  auto distributionStart = std::chrono::high_resolution_clock::now();
 
   // create local matrix
-  // has localNodes rows, with totalNodes columns
-  std::vector<int> localMatrix(localNodes * totalNodes, 0);
+  // has localNodes rows, with totalNodes columns (not needed if the rows are read in place from the shared graph)
+  std::vector<int> localMatrix(sharedGraph ? 0 : localNodes * totalNodes, 0);
+
+  // scatter - process 0 may only hold the packed upper triangle, so it expands one block of full rows at a time
+  if (sharedGraph) {
+    // nothing to send - every process already sees the whole graph
+  } else if (rank == 0) {
+    for (int row = 0; row < localNodes; row++) {
+      adjacencyMatrix.copyRow(row, localMatrix.data() + convertToIndex(row, 0));
+    }
+
+    std::vector<int> block;
+    for (int i = 1; i < numProcs; i++) {
+      block.resize(sendcounts[i] * totalNodes);
+      for (int row = 0; row < sendcounts[i]; row++) {
+        adjacencyMatrix.copyRow(displs[i] + row, block.data() + convertToIndex(row, 0));
+      }
+      MPI_Send(block.data(), sendcounts[i], ROW, i, 0, MPI_COMM_WORLD);
+    }
+  } else {
+    MPI_Recv(localMatrix.data(), localNodes, ROW, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  }
 
-  // scatter
-  MPI_Scatterv(adjacencyMatrix.data(), sendcounts, displs, ROW,  // send info
-               localMatrix.data(), localNodes, ROW,              // receive info
-               0, MPI_COMM_WORLD);
+  auto distributionEnd = std::chrono::high_resolution_clock::now();
+  distributionTime += std::chrono::duration_cast<std::chrono::microseconds>(distributionEnd - distributionStart).count();
+  graphBytes = localMatrix.size() * sizeof(int);
 
   // ------------------ run dijsktra ------------------
   std::vector<int> localDistance(localNodes, INT32_MAX);
-  dijsktra(startNode, localMatrix, localDistance);
+  if (sharedGraph) {
+    dijsktra(startNode, SharedWeights{adjacencyMatrix}, localDistance);
+  } else {
+    dijsktra(startNode, BlockWeights{localMatrix}, localDistance);
+  }
 
   // ------------------ gather results into distanceArray ------------------
   if (rank == 0) {
@@ -238,6 +296,458 @@ void doWork(const int startNode, std::vector<int> &adjacencyMatrix, std::vector<
   MPI_Type_free(&ROW);
 }
 
+// ------------------ sparse engine ------------------
+
+/*
+
+General Idea (distributed delta-stepping):
+  - the dense engine settles one node globally per step, so it always needs totalNodes collective rounds
+  - instead, each process keeps the edges of its block of nodes in CSR (compressed sparse row) form
+  - tentative distances are kept in buckets of width delta; the processes agree on the lowest non-empty bucket, then
+    * relax the light edges (weight <= delta) of every node in the bucket, in synchronous rounds, until the bucket stays empty
+    * relax the heavy edges (weight > delta) of every node that was removed from the bucket (they can't land back in it)
+  - relaxations of nodes owned by other processes are combined per target (only the smallest distance is kept),
+    and exchanged in one MPI_Alltoallv per round
+  - the number of rounds depends on the weighted depth of the graph (divided by delta), not on the number of nodes
+  - with the shared graph, the processes on a node build one CSR of their rows in a shared window instead (see
+    createSharedCSR), and each process searches its rows in place
+
+*/
+
+// compressed sparse row block of the graph
+typedef struct {
+  std::vector<int64_t> offsets;  // edges of local node i are [offsets[i], offsets[i + 1])
+  std::vector<int> targets;      // global node numbers
+  std::vector<int> weights;
+} csr_block;
+
+// the CSR rows a process searches - its own csr_block, or its rows of its node's shared CSR
+typedef struct {
+  int numRows;
+  const int64_t *offsets;  // edges of local node i are [offsets[i], offsets[i + 1]) of targets and weights
+  const int *targets;
+  const int *weights;
+} csr_rows;
+
+csr_rows viewCSR(const csr_block &block) {
+  return {(int)block.offsets.size() - 1, block.offsets.data(), block.targets.data(), block.weights.data()};
+}
+
+// with the shared graph, this process's rows of its node's shared CSR (see createSharedCSR)
+csr_rows sharedRows;
+
+// number of synchronous (exchange) rounds of the last sparse run
+int sparseRounds = 0;
+
+// build the CSR block of the given rows from the matrix
+void buildCSR(const SymmetricMatrix &adjacencyMatrix, const int firstRow, const int numRows, csr_block &block) {
+  std::vector<int> row(totalNodes);
+
+  block.offsets.assign(1, 0);
+  block.targets.clear();
+  block.weights.clear();
+
+  for (int r = 0; r < numRows; r++) {
+    adjacencyMatrix.copyRow(firstRow + r, row.data());
+    for (int col = 0; col < totalNodes; col++) {
+      if (row[col] != 0) {
+        block.targets.push_back(col);
+        block.weights.push_back(row[col]);
+      }
+    }
+    block.offsets.push_back(block.targets.size());
+  }
+}
+
+// send (or receive) an array of ints in chunks, since the count of a message is an int
+const int64_t messageChunk = 1 << 28;
+
+void sendInChunks(const int *buffer, const int64_t count, const int dest, const int tag) {
+  for (int64_t offset = 0; offset < count; offset += messageChunk) {
+    MPI_Send(buffer + offset, std::min(messageChunk, count - offset), MPI_INT, dest, tag, MPI_COMM_WORLD);
+  }
+}
+
+void receiveInChunks(int *buffer, const int64_t count, const int source, const int tag) {
+  for (int64_t offset = 0; offset < count; offset += messageChunk) {
+    MPI_Recv(buffer + offset, std::min(messageChunk, count - offset), MPI_INT, source, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  }
+}
+
+// pick the bucket width: max edge weight / average degree
+int determineDelta(const csr_rows &rows) {
+  int maxWeight = 0;
+  for (int64_t e = rows.offsets[0]; e < rows.offsets[rows.numRows]; e++) maxWeight = std::max(maxWeight, rows.weights[e]);
+
+  long long numEdges = rows.offsets[rows.numRows] - rows.offsets[0];
+  MPI_Allreduce(MPI_IN_PLACE, &maxWeight, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+  MPI_Allreduce(MPI_IN_PLACE, &numEdges, 1, MPI_LONG_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+  double averageDegree = std::max(1.0, (double)numEdges / totalNodes);
+  return std::max(1, (int)(maxWeight / averageDegree));
+}
+
+class DeltaStepping {
+ public:
+  DeltaStepping(const csr_rows &block, const int delta, const int firstNode)
+      : block(block), delta(delta), firstNode(firstNode), numLocal(block.numRows) {
+    distance.assign(numLocal, INT32_MAX);
+    bucketOf.assign(numLocal, -1);
+    inRemoved.assign(numLocal, false);
+    pending.assign(totalNodes, INT32_MAX);
+    outgoing.resize(numProcs);
+
+    // the node/distance pairs are exchanged as an MPI struct
+    node_distance example;
+    buildNodeDistanceType(&example.node, &example.distance, &MPI_NODE_DISTANCE);
+  }
+
+  ~DeltaStepping() {
+    MPI_Type_free(&MPI_NODE_DISTANCE);
+  }
+
+  void run(const int startNode) {
+    if (determineOwner(startNode) == rank) {
+      relaxLocal(startNode - firstNode, 0);
+    }
+
+    while (true) {
+      // agree on the lowest non-empty bucket
+      int current = lowestBucket();
+      MPI_Allreduce(MPI_IN_PLACE, &current, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+      if (current == INT32_MAX) break;
+
+      // light edges - nodes can re-enter the current bucket, so repeat until it stays empty everywhere
+      std::vector<int> removed;
+      bool bucketNonEmpty = true;
+      while (bucketNonEmpty) {
+        std::vector<int> frontier = takeBucket(current);
+        for (int node : frontier) {
+          if (!inRemoved[node]) {
+            inRemoved[node] = true;
+            removed.push_back(node);
+          }
+          relaxEdges(node, true);
+        }
+        exchange();
+
+        bucketNonEmpty = buckets.count(current) > 0;
+        MPI_Allreduce(MPI_IN_PLACE, &bucketNonEmpty, 1, MPI_CXX_BOOL, MPI_LOR, MPI_COMM_WORLD);
+      }
+
+      // heavy edges - these lead to later buckets, so one round is enough
+      for (int node : removed) {
+        relaxEdges(node, false);
+        inRemoved[node] = false;
+      }
+      exchange();
+    }
+  }
+
+  const std::vector<int> &getDistances() const {
+    return distance;
+  }
+
+ private:
+  const csr_rows block;
+  const int delta;
+  const int firstNode;
+  const int numLocal;
+
+  std::vector<int> distance;
+  std::vector<int> bucketOf;  // the bucket a node is currently queued in (-1 if it isn't queued)
+  std::vector<bool> inRemoved;
+  std::map<int, std::vector<int>> buckets;  // bucket -> local nodes (may hold stale entries)
+
+  std::vector<int> pending;                 // the best distance (so far this round) sent to each remote node
+  std::vector<std::vector<int>> outgoing;   // remote nodes with a pending update, per owner
+  MPI_Datatype MPI_NODE_DISTANCE;
+
+  // lower the distance of a local node, and move it to its new bucket
+  void relaxLocal(const int node, const int newDistance) {
+    if (newDistance < distance[node]) {
+      distance[node] = newDistance;
+      bucketOf[node] = newDistance / delta;
+      buckets[bucketOf[node]].push_back(node);
+    }
+  }
+
+  // relax the light (or heavy) edges of a local node
+  void relaxEdges(const int node, const bool light) {
+    for (int64_t e = block.offsets[node]; e < block.offsets[node + 1]; e++) {
+      if ((block.weights[e] <= delta) != light) continue;
+
+      int target = block.targets[e];
+      int newDistance = distance[node] + block.weights[e];
+      int owner = determineOwner(target);
+
+      if (owner == rank) {
+        relaxLocal(target - firstNode, newDistance);
+      } else if (newDistance < pending[target]) {
+        // combine updates to the same remote node - only the smallest is sent
+        if (pending[target] == INT32_MAX) outgoing[owner].push_back(target);
+        pending[target] = newDistance;
+      }
+    }
+  }
+
+  // remove and return the live entries of a bucket
+  std::vector<int> takeBucket(const int bucket) {
+    std::vector<int> frontier;
+    auto it = buckets.find(bucket);
+    if (it == buckets.end()) return frontier;
+
+    for (int node : it->second) {
+      if (bucketOf[node] == bucket) {
+        bucketOf[node] = -1;
+        frontier.push_back(node);
+      }
+    }
+    buckets.erase(it);
+    return frontier;
+  }
+
+  // the lowest bucket that still holds a live entry
+  int lowestBucket() {
+    while (!buckets.empty()) {
+      auto it = buckets.begin();
+      for (int node : it->second) {
+        if (bucketOf[node] == it->first) return it->first;
+      }
+      buckets.erase(it);
+    }
+    return INT32_MAX;
+  }
+
+  // send the combined remote updates to their owners, and apply the ones we receive
+  void exchange() {
+    sparseRounds++;
+
+    int sendcounts[numProcs], recvcounts[numProcs];
+    int sdispls[numProcs], rdispls[numProcs];
+
+    std::vector<node_distance> sendBuffer;
+    for (int i = 0; i < numProcs; i++) {
+      sdispls[i] = sendBuffer.size();
+      sendcounts[i] = outgoing[i].size();
+      for (int target : outgoing[i]) {
+        sendBuffer.push_back({target, pending[target]});
+        pending[target] = INT32_MAX;
+      }
+      outgoing[i].clear();
+    }
+
+    MPI_Alltoall(sendcounts, 1, MPI_INT, recvcounts, 1, MPI_INT, MPI_COMM_WORLD);
+
+    int totalReceived = 0;
+    for (int i = 0; i < numProcs; i++) {
+      rdispls[i] = totalReceived;
+      totalReceived += recvcounts[i];
+    }
+
+    std::vector<node_distance> receiveBuffer(totalReceived);
+    MPI_Alltoallv(sendBuffer.data(), sendcounts, sdispls, MPI_NODE_DISTANCE,        // send info
+                  receiveBuffer.data(), recvcounts, rdispls, MPI_NODE_DISTANCE,  // receive info
+                  MPI_COMM_WORLD);
+
+    for (const node_distance &update : receiveBuffer) {
+      relaxLocal(update.node - firstNode, update.distance);
+    }
+  }
+};
+
+void doWorkSparse(const int startNode, const SymmetricMatrix &adjacencyMatrix, int delta, std::vector<int> &distanceArray) {
+  // ------------------ distribute CSR blocks ------------------
+  int counts[numProcs];
+  int displs[numProcs];
+  determineDistribution(counts, displs);
+
+  auto distributionStart = std::chrono::high_resolution_clock::now();
+
+  // process 0 compresses each block of rows, and only sends the edges
+  // (with the shared graph, every process already has its rows, in its node's shared CSR)
+  csr_block block;
+  if (sharedGraph) {
+    // nothing to distribute
+  } else if (rank == 0) {
+    csr_block other;
+    for (int i = 1; i < numProcs; i++) {
+      buildCSR(adjacencyMatrix, displs[i], counts[i], other);
+
+      // (a block can have more edges than an int can count)
+      int64_t numEdges = other.targets.size();
+      MPI_Send(&numEdges, 1, MPI_INT64_T, i, 0, MPI_COMM_WORLD);
+      MPI_Send(other.offsets.data(), counts[i] + 1, MPI_INT64_T, i, 1, MPI_COMM_WORLD);
+      sendInChunks(other.targets.data(), numEdges, i, 2);
+      sendInChunks(other.weights.data(), numEdges, i, 3);
+    }
+    buildCSR(adjacencyMatrix, displs[0], counts[0], block);
+  } else {
+    int64_t numEdges;
+    MPI_Recv(&numEdges, 1, MPI_INT64_T, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+    block.offsets.resize(counts[rank] + 1);
+    block.targets.resize(numEdges);
+    block.weights.resize(numEdges);
+    MPI_Recv(block.offsets.data(), counts[rank] + 1, MPI_INT64_T, 0, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    receiveInChunks(block.targets.data(), numEdges, 0, 2);
+    receiveInChunks(block.weights.data(), numEdges, 0, 3);
+  }
+
+  auto distributionEnd = std::chrono::high_resolution_clock::now();
+  distributionTime += std::chrono::duration_cast<std::chrono::microseconds>(distributionEnd - distributionStart).count();
+  csr_rows rows = sharedGraph ? sharedRows : viewCSR(block);
+  if (!sharedGraph) {
+    graphBytes = block.offsets.size() * sizeof(int64_t) + (block.targets.size() + block.weights.size()) * sizeof(int);
+  }
+
+  // ------------------ run delta-stepping ------------------
+  if (delta <= 0) delta = determineDelta(rows);
+
+  sparseRounds = 0;
+  DeltaStepping search(rows, delta, displs[rank]);
+  search.run(startNode);
+
+  // ------------------ gather results into distanceArray ------------------
+  if (rank == 0) {
+    distanceArray.resize(totalNodes);
+  }
+
+  MPI_Gatherv(search.getDistances().data(), counts[rank], MPI_INT,  // send info
+              distanceArray.data(), counts, displs, MPI_INT,        // receive info
+              0, MPI_COMM_WORLD);
+}
+
+// ------------------ node-local shared graph ------------------
+
+/*
+
+General Idea:
+  - by default, process 0 holds the whole graph, and every process receives its own copy of its rows
+  - with the shared graph, the processes on a node share one copy of the graph (full or packed) in a shared memory window
+    * the first process on each node allocates the window, and the others map the same memory
+    * process 0 reads the graph straight into its node's window
+    * the first process on every other node receives the graph with one broadcast - the only message passing
+  - every process then reads its rows in place, so nothing is copied within a node
+  - the sparse engine searches CSR rows, so the processes on a node then build one CSR of all their rows in a second shared
+    window (each process fills its own rows), and the matrix is freed - the node holds the CSR once, and each process
+    searches its rows of it in place
+
+*/
+
+void createSharedGraph(std::ifstream &GraphIn, const bool upperOnly, MPI_Comm nodeComm, MPI_Win &window, SymmetricMatrix &adjacencyMatrix) {
+  int nodeRank;
+  MPI_Comm_rank(nodeComm, &nodeRank);
+
+  // the first process on each node owns the memory, the others allocate nothing
+  const size_t numEntries = SymmetricMatrix::storedSize(totalNodes, packedGraph);
+  MPI_Aint windowSize = nodeRank == 0 ? numEntries * sizeof(int) : 0;
+
+  int *entries;
+  MPI_Win_allocate_shared(windowSize, sizeof(int), MPI_INFO_NULL, nodeComm, &entries, &window);
+
+  // find the memory of the first process on the node
+  int dispUnit;
+  MPI_Win_shared_query(window, 0, &windowSize, &dispUnit, &entries);
+  adjacencyMatrix.attach(totalNodes, entries, packedGraph);
+
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, window);
+
+  // the first process on each node fills the window
+  MPI_Comm leaderComm;
+  MPI_Comm_split(MPI_COMM_WORLD, nodeRank == 0 ? 0 : MPI_UNDEFINED, rank, &leaderComm);
+
+  if (nodeRank == 0) {
+    if (rank == 0) {
+      readGraphEntries(GraphIn, upperOnly, adjacencyMatrix);
+    }
+
+    // broadcast in chunks, since the count is an int
+    const size_t chunk = 1 << 28;
+    for (size_t offset = 0; offset < numEntries; offset += chunk) {
+      MPI_Bcast(entries + offset, std::min(chunk, numEntries - offset), MPI_INT, 0, leaderComm);
+    }
+
+    MPI_Comm_free(&leaderComm);
+  }
+
+  // make the writes visible to the other processes on the node
+  MPI_Win_sync(window);
+  MPI_Barrier(nodeComm);
+  MPI_Win_sync(window);
+
+  graphBytes = nodeRank == 0 ? numEntries * sizeof(int) : 0;
+}
+
+// build one CSR of the rows of the processes on this node in a shared window (from the shared matrix, which is then
+// freed), and point rows at this process's rows of it
+void createSharedCSR(MPI_Comm nodeComm, MPI_Win &graphWindow, SymmetricMatrix &adjacencyMatrix, MPI_Win &csrWindow, csr_rows &rows) {
+  int nodeRank;
+  MPI_Comm_rank(nodeComm, &nodeRank);
+
+  int counts[numProcs];
+  int displs[numProcs];
+  determineDistribution(counts, displs);
+
+  // count the edges of our rows
+  std::vector<int> row(totalNodes);
+  long long numEdges = 0;
+  for (int r = 0; r < counts[rank]; r++) {
+    adjacencyMatrix.copyRow(displs[rank] + r, row.data());
+    for (int col = 0; col < totalNodes; col++) numEdges += row[col] != 0;
+  }
+
+  // where our rows and edges go in the node's CSR (the processes on the node are in rank order), and how big it is
+  long long mine[2] = {counts[rank], numEdges};
+  long long before[2] = {0, 0};
+  long long total[2];
+  MPI_Exscan(mine, before, 2, MPI_LONG_LONG, MPI_SUM, nodeComm);
+  if (nodeRank == 0) before[0] = before[1] = 0;
+  MPI_Allreduce(mine, total, 2, MPI_LONG_LONG, MPI_SUM, nodeComm);
+
+  // the first process on the node owns the memory: the offsets of every row on the node, then the targets, then the weights
+  const size_t csrBytes = (total[0] + 1) * sizeof(int64_t) + 2 * total[1] * sizeof(int);
+  MPI_Aint windowSize = nodeRank == 0 ? csrBytes : 0;
+  char *base;
+  MPI_Win_allocate_shared(windowSize, 1, MPI_INFO_NULL, nodeComm, &base, &csrWindow);
+
+  int dispUnit;
+  MPI_Win_shared_query(csrWindow, 0, &windowSize, &dispUnit, &base);
+  int64_t *offsets = (int64_t *)base;
+  int *targets = (int *)(offsets + total[0] + 1);
+  int *weights = targets + total[1];
+
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, csrWindow);
+
+  // fill our rows (the offset our first row starts at is written by the process before us)
+  int64_t edge = before[1];
+  if (nodeRank == 0) offsets[0] = 0;
+  for (int r = 0; r < counts[rank]; r++) {
+    adjacencyMatrix.copyRow(displs[rank] + r, row.data());
+    for (int col = 0; col < totalNodes; col++) {
+      if (row[col] != 0) {
+        targets[edge] = col;
+        weights[edge] = row[col];
+        edge++;
+      }
+    }
+    offsets[before[0] + r + 1] = edge;
+  }
+
+  // make the writes visible to the other processes on the node
+  MPI_Win_sync(csrWindow);
+  MPI_Barrier(nodeComm);
+  MPI_Win_sync(csrWindow);
+
+  // the matrix isn't needed any more
+  MPI_Win_unlock_all(graphWindow);
+  MPI_Win_free(&graphWindow);
+  adjacencyMatrix.attach(0, nullptr);
+
+  rows = {counts[rank], offsets + before[0], targets, weights};
+  graphBytes = nodeRank == 0 ? csrBytes : 0;
+}
+
 int main(int argc, char *argv[]) {
   MPI_Init(&argc, &argv);
 
@@ -246,8 +756,26 @@ int main(int argc, char *argv[]) {
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
   // get the command line arguments
-  if (argc != 3) {
-    if (rank == 0) std::cout << "Usage: " << argv[0] << " <graph filename> <start node>" << std::endl;
+  bool sparse = false;
+  int delta = 0;  // 0 means it is chosen from the graph
+  bool usageError = argc < 3;
+  for (int i = 3; i < argc && !usageError; i++) {
+    std::string option(argv[i]);
+    if (option == "--sparse") {
+      sparse = true;
+    } else if (option == "--shared") {
+      sharedGraph = true;
+    } else if (option == "--packed") {
+      packedGraph = true;
+    } else if (option == "--delta" && i + 1 < argc) {
+      delta = atoi(argv[++i]);
+    } else {
+      usageError = true;
+    }
+  }
+
+  if (usageError) {
+    if (rank == 0) std::cout << "Usage: " << argv[0] << " <graph filename> <start node> <OPTIONAL: --sparse> <OPTIONAL: --delta <bucket width>> <OPTIONAL: --shared> <OPTIONAL: --packed>" << std::endl;
     MPI_Finalize();
     return 0;
   }
@@ -255,34 +783,26 @@ int main(int argc, char *argv[]) {
   std::string filename(argv[1]);
   int startNode = atoi(argv[2]);
 
-  // read in the graph
-  std::vector<int> adjacencyMatrix;
+  // the processes that share a node (used for the shared graph, and to report memory per node)
+  MPI_Comm nodeComm;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+
+  auto setupStart = std::chrono::high_resolution_clock::now();
+
+  // read in the graph (only the upper triangle is stored, with --packed)
+  SymmetricMatrix adjacencyMatrix;
+  std::ifstream GraphIn;
+  bool upperOnly = false;
   bool inputError = false;
   if (rank == 0) {
-    std::ifstream GraphIn(inputPath + filename);
-
-    GraphIn.ignore(INT32_MAX, '\n');  // ignore the first line
-    GraphIn >> totalNodes;
+    GraphIn.open(inputPath + filename);
+    totalNodes = readGraphHeader(GraphIn, upperOnly);
 
     // if the start vertex is >= than the number of vertices, throw error
     if (startNode < 0 || startNode >= totalNodes) {
       std::cout << "Please choose a valid start vertex (i.e. a value between 0 and " << totalNodes - 1 << ", inclusive)" << std::endl;
       inputError = true;
-    } else {
-      // create the adjacency matrix skeleton
-      // initialise all elements to 0
-      adjacencyMatrix.resize(totalNodes * totalNodes, 0);
-
-      // read in the adjacency matrix
-      for (int row = 0; row < totalNodes; row++) {
-        for (int col = 0; col < totalNodes; col++) {
-          GraphIn >> adjacencyMatrix[convertToIndex(row, col)];  // safe to convert since rank 0 has the correct numNodes
-        }
-      }
     }
-
-    // close the input file
-    GraphIn.close();
   }
 
   // check if there were any errors with the graph
@@ -295,7 +815,27 @@ int main(int argc, char *argv[]) {
   // broadcast the number of nodes
   MPI_Bcast(&totalNodes, 1, MPI_INT, 0, MPI_COMM_WORLD);
 
-  // have now read all the input into process 0
+  MPI_Win window = MPI_WIN_NULL;
+  MPI_Win csrWindow = MPI_WIN_NULL;
+  size_t loadedBytes = 0;
+  if (sharedGraph) {
+    createSharedGraph(GraphIn, upperOnly, nodeComm, window, adjacencyMatrix);
+    if (sparse) createSharedCSR(nodeComm, window, adjacencyMatrix, csrWindow, sharedRows);
+    loadedBytes = graphBytes;
+    graphBytes = 0;
+  } else if (rank == 0) {
+    adjacencyMatrix.resize(totalNodes, packedGraph);
+    readGraphEntries(GraphIn, upperOnly, adjacencyMatrix);
+    loadedBytes = adjacencyMatrix.numEntries() * sizeof(int);
+  }
+
+  // close the input file
+  if (rank == 0) GraphIn.close();
+
+  MPI_Barrier(MPI_COMM_WORLD);
+  auto setupEnd = std::chrono::high_resolution_clock::now();
+
+  // have now read all the input into process 0 (or into the shared graph of every node)
 
   // get an average runtime
   u_int64_t runTime = 0;
@@ -305,7 +845,11 @@ int main(int argc, char *argv[]) {
 
     // ------------------ do work ------------------
     std::vector<int> distanceArray;  // only meaningful for process 0
-    doWork(startNode, adjacencyMatrix, distanceArray);
+    if (sparse) {
+      doWorkSparse(startNode, adjacencyMatrix, delta, distanceArray);
+    } else {
+      doWork(startNode, adjacencyMatrix, distanceArray);
+    }
 
     auto endTime = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime);
@@ -333,9 +877,31 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  // memory per node: the graph loaded on the node, plus the rows distributed to its processes
+  long long nodeBytes = 0;
+  long long rankBytes = loadedBytes + graphBytes;
+  MPI_Reduce(&rankBytes, &nodeBytes, 1, MPI_LONG_LONG, MPI_SUM, 0, nodeComm);
+
+  long long maxNodeBytes = 0;
+  MPI_Reduce(&nodeBytes, &maxNodeBytes, 1, MPI_LONG_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+
+  // setup: loading the graph once, plus the (average) distribution of the rows in each iteration
+  u_int64_t maxDistributionTime = 0;
+  MPI_Reduce(&distributionTime, &maxDistributionTime, 1, MPI_UINT64_T, MPI_MAX, 0, MPI_COMM_WORLD);
+  double loadTime = std::chrono::duration_cast<std::chrono::microseconds>(setupEnd - setupStart).count() / 1000.0;
+
   // print average runtime and results
   if (rank == 0) {
-    std::cout << "MPI average running time: " << (double)runTime / averageIterations << "ms" << std::endl;
+    if (sparse) {
+      std::cout << "MPI (sparse) average running time: " << (double)runTime / averageIterations << "ms" << std::endl;
+      std::cout << "MPI (sparse) synchronous rounds: " << sparseRounds << std::endl;
+    } else {
+      std::cout << "MPI average running time: " << (double)runTime / averageIterations << "ms" << std::endl;
+    }
+
+    std::cout << "MPI setup time" << (sharedGraph ? " (shared graph)" : "") << ": " << loadTime + maxDistributionTime / 1000.0 / averageIterations
+              << "ms (load " << loadTime << "ms, distribute " << maxDistributionTime / 1000.0 / averageIterations << "ms)" << std::endl;
+    std::cout << "MPI graph memory per node" << (sharedGraph ? " (shared graph)" : "") << ": " << maxNodeBytes / (1024.0 * 1024.0) << "MB" << std::endl;
 
     // print result to file
     std::ofstream GraphOut(outputPath + std::to_string(startNode) + "-" + filename);
@@ -349,6 +915,15 @@ int main(int argc, char *argv[]) {
   }
 
   // clean up all the processes
+  if (window != MPI_WIN_NULL) {
+    MPI_Win_unlock_all(window);
+    MPI_Win_free(&window);
+  }
+  if (csrWindow != MPI_WIN_NULL) {
+    MPI_Win_unlock_all(csrWindow);
+    MPI_Win_free(&csrWindow);
+  }
+  MPI_Comm_free(&nodeComm);
   MPI_Finalize();
   return 0;
 }
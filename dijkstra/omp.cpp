@@ -7,6 +7,8 @@
 #include <unordered_set>
 #include <vector>
 
+#include "symmetricMatrix.h"
+
 /*
 
 General Idea:
@@ -36,15 +38,18 @@ bool compareArrays(const std::vector<int> &first, const std::vector<int> &second
 }
 
 // find the shortest paths from the start node to all other nodes
-void dijstra(const std::vector<std::vector<int>> &adjacencyMatrix, std::vector<int> &distanceArray) {
+void dijstra(const SymmetricMatrix &adjacencyMatrix, std::vector<int> &distanceArray) {
   // a set of nodes that we know the shortest path to
   std::unordered_set<int> terminalNodes;
 
+  // the full row of the node being visited is expanded here, if the matrix is packed (reused every iteration)
+  std::vector<int> buffer(distanceArray.size());
+
   // loop while we have not found all the shortest paths
   while (terminalNodes.size() != distanceArray.size()) {
     int node;
     int overallMinDistance = INT32_MAX;
-#pragma omp parallel shared(terminalNodes, adjacencyMatrix, distanceArray, node, overallMinDistance) default(none)
+#pragma omp parallel shared(terminalNodes, adjacencyMatrix, distanceArray, node, overallMinDistance, buffer) default(none)
     {
       // find the node with the shortest path that we have not visited yet
       // these values are private to each thread
@@ -78,19 +83,32 @@ void dijstra(const std::vector<std::vector<int>> &adjacencyMatrix, std::vector<i
 #pragma omp barrier
 
 // visit this node
-#pragma omp single
+#pragma omp single nowait
       terminalNodes.insert(node);
 
+      // its row - read in place, or expanded once, so the loop below reads it contiguously (each thread expands its share of
+      // the columns)
+      const int *row;
+      {
+        const int numNodes = distanceArray.size();
+        const int thread = omp_get_thread_num(), threads = omp_get_num_threads();
+        row = adjacencyMatrix.fullRow(node, buffer.data(), (int64_t)numNodes * thread / threads, (int64_t)numNodes * (thread + 1) / threads);
+      }
+
+// wait for the whole row (and the node to be closed)
+#pragma omp barrier
+
 // loop through all its neighbours
 #pragma omp for schedule(static)  // static scheduling means false sharing becomes negligible on large graphs
       for (int i = 0; i < distanceArray.size(); i++) {
-        if (adjacencyMatrix[node][i] != 0) {
+        int weight = row[i];
+        if (weight != 0) {
           // an edge exists between the two nodes
           if (terminalNodes.find(i) == terminalNodes.end()) {
             // we have not closed the neighbour yet
 
             // update the shortest path to the neighbour, if it is shorter
-            distanceArray[i] = std::min(distanceArray[i], distanceArray[node] + adjacencyMatrix[node][i]);
+            distanceArray[i] = std::min(distanceArray[i], distanceArray[node] + weight);
           }
         }
       }
@@ -99,8 +117,9 @@ void dijstra(const std::vector<std::vector<int>> &adjacencyMatrix, std::vector<i
 }  // function
 
 int main(int argc, char *argv[]) {
-  if (argc != 3) {
-    std::cout << "Usage: " << argv[0] << " <graph filename> <start node>" << std::endl;
+  const bool packed = argc == 4 && std::string(argv[3]) == "--packed";
+  if (argc != 3 && !packed) {
+    std::cout << "Usage: " << argv[0] << " <graph filename> <start node> <OPTIONAL: --packed>" << std::endl;
     return 0;
   }
 
@@ -111,28 +130,19 @@ int main(int argc, char *argv[]) {
   // read in the graph from the file
   std::ifstream GraphIn(inputPath + filename);
 
-  int totalNodes;
-  GraphIn.ignore(INT32_MAX, '\n');  // ignore the first line
-  GraphIn >> totalNodes;
+  // read in the adjacency matrix (only the upper triangle is stored, with --packed)
+  SymmetricMatrix adjacencyMatrix;
+  int totalNodes = readGraph(GraphIn, adjacencyMatrix, packed);
+
+  // close the input file
+  GraphIn.close();
 
   // if the start vertex is >= than the number of vertices, throw error
   if (startNode < 0 || startNode >= totalNodes) {
     std::cout << "Please choose a valid start vertex (i.e. a value between 0 and " << totalNodes - 1 << ", inclusive)" << std::endl;
-    GraphIn.close();
     return 0;
   }
 
-  // read in the adjacency matrix
-  std::vector<std::vector<int>> adjacencyMatrix(totalNodes, std::vector<int>(totalNodes, 0));  // initialise all elements to 0
-  for (int row = 0; row < totalNodes; row++) {
-    for (int col = 0; col < totalNodes; col++) {
-      GraphIn >> adjacencyMatrix[row][col];
-    }
-  }
-
-  // close the input file
-  GraphIn.close();
-
   // keep track of the total running time
   u_int64_t runTime = 0;
 
@@ -1,12 +1,12 @@
 
 # make sure we have the correct arguments
-if [ "$#" != 5 ]
+if [ "$#" -lt 5 ] || [ "$#" -gt 6 ]
 then
   echo "The input graph must already have been generated!"
   echo ""
   echo "Specify the input graph filename (no path), the vertex to start from, and the number of threads/processes to run"
   echo ""
-  echo "Usage: ${0} <filename> <start node> <num threads/processes> <run serial [y/n]> <run parallel [y/n]>"
+  echo "Usage: ${0} <filename> <start node> <num threads/processes> <run serial [y/n]> <run parallel [y/n]> <OPTIONAL: run contraction hierarchy [y/n]>"
   exit
 fi
 
@@ -16,6 +16,7 @@ startNode=$2
 numProcs=$3
 runSerial=$4
 runParallel=$5
+runCH=${6:-n}
 
 if [ $runParallel == "y" ] && [ $numProcs == "1" ]
 then
@@ -27,6 +28,7 @@ inputPath="graphs/"
 serialOutput="serial-output/${startNode}-${filename}"
 mpiOutput="mpi-output/${startNode}-${filename}"
 ompOutput="omp-output/${startNode}-${filename}"
+chOutput="ch-output/${startNode}-${filename}"
 
 # make the serial and parallel versions
 echo "Making executables"
@@ -62,6 +64,29 @@ then
   echo
 fi
 
+# build the contraction hierarchy index, then query it from the start node
+if [ $runCH == "y" ]
+then
+  echo "Running contraction hierarchy"
+  mkdir -p ch-index ch-output
+  rm -f $chOutput
+  export OMP_NUM_THREADS=$numProcs
+  ./chPreprocess $filename
+  ./chQuery $filename $startNode
+  echo "Done contraction hierarchy"
+  echo
+
+  # check ch correctness
+  DIFF=$(diff $serialOutput $chOutput)
+  if [ "$DIFF" ]
+  then 
+    echo "The serial and contraction hierarchy outputs are different!"
+  else
+    echo "The serial and contraction hierarchy outputs are the same and correct!"
+  fi
+  echo
+fi
+
 # compare the serial and parallel outputs to VERIFY
 # only compare if we want to check the parallel version
 if [ $runParallel == "y" ] 
@@ -83,6 +108,38 @@ then
   else
     echo "The serial and OpenMP outputs are the same and correct!"
   fi
+  echo
+
+  # check the last process's nodes too: start from the last process's first node, with a number of processes (no more than
+  # we were given) that doesn't divide the nodes evenly (so the last process has a different number of nodes to the others)
+  numNodes=$(sed -n 2p $inputPath$filename)
+  unevenProcs=$numProcs
+  while [ $unevenProcs -gt 1 ] && [ $(((2 * numNodes + unevenProcs) / (2 * unevenProcs) * unevenProcs)) == $numNodes ]
+  do
+    unevenProcs=$((unevenProcs - 1))
+  done
+
+  if [ $unevenProcs -gt 1 ]
+  then
+    lastStart=$(((2 * numNodes + unevenProcs) / (2 * unevenProcs) * (unevenProcs - 1)))
+
+    echo "Running serial and MPI from node ${lastStart} (${unevenProcs} processes)"
+    lastSerialOutput="serial-output/${lastStart}-${filename}"
+    lastMpiOutput="mpi-output/${lastStart}-${filename}"
+    rm -f $lastSerialOutput $lastMpiOutput
+    ./serial $filename $lastStart
+    mpirun -np $unevenProcs ./mpi $filename $lastStart
+    echo
+
+    # (a missing output - the run failed - is a difference too)
+    DIFF=$(diff $lastSerialOutput $lastMpiOutput 2>&1)
+    if [ "$DIFF" ]
+    then 
+      echo "The serial and MPI outputs from the last process's first node are different!"
+    else
+      echo "The serial and MPI outputs from the last process's first node are the same and correct!"
+    fi
+  fi
 fi
 
 # clean up
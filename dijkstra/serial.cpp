@@ -6,6 +6,8 @@
 #include <unordered_set>
 #include <vector>
 
+#include "symmetricMatrix.h"
+
 using namespace std;
 
 /*
@@ -65,10 +67,13 @@ int pickShortestUnvisitedNode(const unordered_set<int> &terminalNodes, const vec
 }
 
 // find the shortest paths from the start node to all other nodes
-void dijkstra(const int startNode, const vector<vector<int>> &adjacencyMatrix, vector<int> &distanceArray) {
+void dijkstra(const int startNode, const SymmetricMatrix &adjacencyMatrix, vector<int> &distanceArray) {
   // a set of nodes that we know the shortest path to
   unordered_set<int> terminalNodes;
 
+  // the full row of the node being visited is expanded here, if the matrix is packed (reused every iteration)
+  vector<int> buffer(distanceArray.size());
+
   // loop while we have not found all the shortest paths
   while (terminalNodes.size() != distanceArray.size()) {
     // find the node with the shortest path that we have not visited yet
@@ -77,15 +82,19 @@ void dijkstra(const int startNode, const vector<vector<int>> &adjacencyMatrix, v
     // visit this node
     terminalNodes.insert(node);
 
+    // its row - read in place, or expanded once, so the loop below reads it contiguously
+    const int *row = adjacencyMatrix.fullRow(node, buffer.data());
+
     // loop through all its neighbours
     for (int i = 0; i < distanceArray.size(); i++) {
-      if (adjacencyMatrix[node][i] != 0) {
+      int weight = row[i];
+      if (weight != 0) {
         // an edge exists between the two nodes
         if (terminalNodes.find(i) == terminalNodes.end()) {
           // we have not closed the neighbour yet
 
           // update the shortest path to the neighbour, if it is shorter
-          distanceArray[i] = min(distanceArray[i], distanceArray[node] + adjacencyMatrix[node][i]);
+          distanceArray[i] = min(distanceArray[i], distanceArray[node] + weight);
         }
       }
     }
@@ -93,8 +102,9 @@ void dijkstra(const int startNode, const vector<vector<int>> &adjacencyMatrix, v
 }
 
 int main(int argc, char *argv[]) {
-  if (argc != 3) {
-    cout << "Usage: " << argv[0] << " <graph filename> <start vertex>" << endl;
+  const bool packed = argc == 4 && string(argv[3]) == "--packed";
+  if (argc != 3 && !packed) {
+    cout << "Usage: " << argv[0] << " <graph filename> <start vertex> <OPTIONAL: --packed>" << endl;
     return 0;
   }
 
@@ -105,28 +115,19 @@ int main(int argc, char *argv[]) {
   // read in the graph from the file
   ifstream GraphIn(inputPath + filename);
 
-  int numVertices;
-  GraphIn.ignore(INT32_MAX, '\n');  // ignore the first line
-  GraphIn >> numVertices;
+  // read in the adjacency matrix (only the upper triangle is stored, with --packed)
+  SymmetricMatrix adjacencyMatrix;
+  int numVertices = readGraph(GraphIn, adjacencyMatrix, packed);
+
+  // close the input file
+  GraphIn.close();
 
   // if the start vertex is >= than the number of vertices, throw error
   if (startVertex < 0 || startVertex >= numVertices) {
     cout << "Please choose a valid start vertex (i.e. a value between 0 and " << numVertices - 1 << ", inclusive)" << endl;
-    GraphIn.close();
     return 0;
   }
 
-  // read in the adjacency matrix
-  vector<vector<int>> adjacencyMatrix(numVertices, vector<int>(numVertices, 0));  // initialise all elements to 0
-  for (int row = 0; row < numVertices; row++) {
-    for (int col = 0; col < numVertices; col++) {
-      GraphIn >> adjacencyMatrix[row][col];
-    }
-  }
-
-  // close the input file
-  GraphIn.close();
-
   // keep track of the total running time
   u_int64_t runTime = 0;
 
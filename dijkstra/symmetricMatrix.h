@@ -0,0 +1,202 @@
+#ifndef SYMMETRIC_MATRIX_H
+#define SYMMETRIC_MATRIX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+/*
+
+Storage of a symmetric adjacency matrix (our graphs are undirected), either full or packed:
+  - full (the default): all n^2 entries, row by row - every row is contiguous, so the searches read it in place
+  - packed (opt-in, for graphs that don't fit in memory otherwise): only the entries strictly above the main diagonal are
+    stored (there are no self loops, so the diagonal is always 0)
+    * row r holds the entries (r, r + 1), ..., (r, n - 1), and the rows are stored one after the other
+    * entry (row, col) with row > col is the same edge as (col, row), so it is read from the upper triangle
+    * this is n(n - 1)/2 entries instead of n^2, which halves the memory of every dense graph - but the columns of a row before
+      the diagonal are scattered down the triangle, so a full row has to be gathered, which makes the searches slower
+
+Graph files come in two formats (told apart by the first line):
+  - full:  "Density: <p>", then <n>, then n rows of n weights
+  - upper: "Density: <p> (upper triangle)", then <n>, then n - 1 rows, where row r has the n - r - 1 weights above the diagonal
+
+*/
+
+const std::string upperTriangleTag = "(upper triangle)";
+
+class SymmetricMatrix {
+ public:
+  SymmetricMatrix() = default;
+
+  // the entries may live outside this object (see attach), so it can't be copied - only moved
+  SymmetricMatrix(const SymmetricMatrix &) = delete;
+  SymmetricMatrix &operator=(const SymmetricMatrix &) = delete;
+  SymmetricMatrix(SymmetricMatrix &&) = default;
+  SymmetricMatrix &operator=(SymmetricMatrix &&) = default;
+
+  // the number of entries stored for an n x n matrix
+  static size_t packedSize(const int n) {
+    return (size_t)n * (n - 1) / 2;
+  }
+
+  static size_t storedSize(const int n, const bool packed) {
+    return packed ? packedSize(n) : (size_t)n * n;
+  }
+
+  // create an n x n matrix of 0s
+  void resize(const int n, const bool packed = false) {
+    storage.assign(storedSize(n, packed), 0);
+    attach(n, storage.data(), packed);
+  }
+
+  // use entries that live elsewhere (e.g. in a shared memory window) - the caller keeps them alive
+  void attach(const int n, int *external, const bool packed = false) {
+    numNodes = n;
+    entries = external;
+    isPacked = packed;
+
+    // entry (r, c) is at rowStart[r] + c - packed, rowStart[r] = (index of entry (r, r + 1)) - (r + 1) (only for c > r)
+    rowStart.resize(n);
+    size_t start = 0;
+    for (int r = 0; r < n; r++) {
+      rowStart[r] = packed ? (int64_t)start - (r + 1) : (int64_t)r * n;
+      start += n - r - 1;
+    }
+  }
+
+  int size() const {
+    return numNodes;
+  }
+
+  bool packed() const {
+    return isPacked;
+  }
+
+  // the weight of the edge between row and col (in any order) - 0 if there is no edge
+  int at(const int row, const int col) const {
+    if (!isPacked) return entries[rowStart[row] + col];
+    if (row < col) return entries[rowStart[row] + col];
+    if (row > col) return entries[rowStart[col] + row];
+    return 0;
+  }
+
+  // set the weight of the (undirected) edge between row and col
+  void set(const int row, const int col, const int weight) {
+    if (!isPacked) {
+      entries[rowStart[row] + col] = weight;
+      entries[rowStart[col] + row] = weight;
+      return;
+    }
+    if (row < col) entries[rowStart[row] + col] = weight;
+    if (row > col) entries[rowStart[col] + row] = weight;
+  }
+
+  // the contiguous part of a row: entries (row, row + 1), ..., (row, n - 1)
+  const int *upperRow(const int row) const {
+    return entries + rowStart[row] + row + 1;
+  }
+
+  // a full row (all n columns): in place when the whole matrix is stored, otherwise expanded into the buffer
+  const int *fullRow(const int row, int *buffer) const {
+    return fullRow(row, buffer, 0, numNodes);
+  }
+
+  // the same, but only columns [first, last) are expanded into the buffer (so threads can share the work) - the other columns
+  // of the buffer must be expanded before the whole row is read
+  const int *fullRow(const int row, int *buffer, const int first, const int last) const {
+    if (!isPacked) return entries + rowStart[row];
+    copyRow(row, buffer, first, last);
+    return buffer;
+  }
+
+  // expand a full row (all n columns) into the buffer
+  void copyRow(const int row, int *buffer) const {
+    copyRow(row, buffer, 0, numNodes);
+  }
+
+  // expand columns [first, last) of a row into the same columns of the buffer
+  void copyRow(const int row, int *buffer, const int first, const int last) const {
+    if (!isPacked) {
+      std::copy(entries + rowStart[row] + first, entries + rowStart[row] + last, buffer + first);
+      return;
+    }
+
+    // the columns before the diagonal walk down the upper triangle
+    for (int col = first; col < last && col < row; col++) {
+      buffer[col] = entries[rowStart[col] + row];
+    }
+    if (row >= first && row < last) buffer[row] = 0;
+
+    // the columns after the diagonal are contiguous
+    const int *upper = upperRow(row);
+    for (int col = std::max(first, row + 1); col < last; col++) {
+      buffer[col] = upper[col - row - 1];
+    }
+  }
+
+  // the number of stored entries
+  size_t numEntries() const {
+    return storedSize(numNodes, isPacked);
+  }
+
+  const int *data() const {
+    return entries;
+  }
+
+  int *data() {
+    return entries;
+  }
+
+ private:
+  int numNodes = 0;
+  bool isPacked = false;
+  int *entries = nullptr;
+  std::vector<int64_t> rowStart;
+  std::vector<int> storage;
+};
+
+// read the first two lines of a graph file (in either format) - returns the number of nodes
+inline int readGraphHeader(std::ifstream &GraphIn, bool &upperOnly) {
+  std::string header;
+  std::getline(GraphIn, header);
+  upperOnly = header.find(upperTriangleTag) != std::string::npos;
+
+  int numNodes;
+  GraphIn >> numNodes;
+  return numNodes;
+}
+
+// read the weights of a graph file into a matrix that already has the right size
+inline void readGraphEntries(std::ifstream &GraphIn, const bool upperOnly, SymmetricMatrix &adjacencyMatrix) {
+  const int numNodes = adjacencyMatrix.size();
+
+  int weight;
+  for (int row = 0; row < numNodes; row++) {
+    if (!upperOnly) {
+      // skip the lower triangle and the diagonal - it is the same as the upper triangle
+      for (int col = 0; col <= row; col++) GraphIn >> weight;
+    }
+
+    for (int col = row + 1; col < numNodes; col++) {
+      GraphIn >> weight;
+      adjacencyMatrix.set(row, col, weight);
+    }
+  }
+}
+
+// read a graph file (in either format) into full (or packed) storage - returns the number of nodes
+inline int readGraph(std::ifstream &GraphIn, SymmetricMatrix &adjacencyMatrix, const bool packed = false) {
+  bool upperOnly;
+  int numNodes = readGraphHeader(GraphIn, upperOnly);
+
+  adjacencyMatrix.resize(numNodes, packed);
+  readGraphEntries(GraphIn, upperOnly, adjacencyMatrix);
+
+  return numNodes;
+}
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef ACTIVE_TILES_H
+#define ACTIVE_TILES_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "boardFile.h"
+#include "paddedBoard.h"
+
+/*
+
+Active-tile tracking (on top of the padded byte board):
+  - the board is split into tiles, and each tile remembers whether any of its cells differ from two generations ago
+  - a cell's next value only depends on its neighbourhood, so if a tile and its 8 neighbouring tiles are the same as two
+    generations ago, the tile's next generation is the same as last generation's - and the next generation's buffer
+    (which held last generation) already has it, so the tile is skipped entirely
+  - comparing with two generations ago (instead of one) means period 2 oscillators (blinkers, toads, beacons) are skipped
+    too, not only still lifes
+  - the tile rows above the first and below the last are given by the caller: the other end of the board (wraparound),
+    or the boundary tile rows of the neighbouring processes
+  - the first two generations evaluate every tile, since there is no generation two before them yet
+  - most of a random board settles into still lifes and small oscillators, so only a small fraction of the tiles stays active
+  - the change in the board's hash (see boardFile.h) can be kept too: an evaluated tile hashes the cells that changed, and a
+    skipped tile's cells are the ones from two generations ago, so its change is the same as last generation's
+  - the time spent on each row of tiles can be measured too, so the MPI version can move its strip boundaries to where the
+    active tiles are
+
+*/
+
+const int defaultTileHeight = 16;
+const int defaultTileWidth = 32;
+
+class ActiveTiles {
+ public:
+  int tileRows = 0;     // number of tiles down the board
+  int tileColumns = 0;  // number of tiles across the board
+  int tileHeight = 0;
+  int tileWidth = 0;
+  int rows = 0;
+  int columns = 0;
+
+  int generation = 0;
+  LifeRule rule;
+
+  // keep the change in the board's hash in each step (the first cell of the board is cell firstCellIndex of the whole board)
+  bool hashing = false;
+  uint64_t firstCellIndex = 0;
+  uint64_t hashChange = 0;
+
+  // measure the time spent on each row of tiles (in seconds, added up in tileRowTimes)
+  bool timing = false;
+  std::vector<double> tileRowTimes;
+
+  // statistics
+  uint64_t evaluated = 0;
+  uint64_t considered = 0;
+
+  void resize(const int numRows, const int numColumns, const int height = defaultTileHeight, const int width = defaultTileWidth) {
+    rows = numRows;
+    columns = numColumns;
+    tileHeight = height;
+    tileWidth = width;
+    tileRows = (rows + tileHeight - 1) / tileHeight;
+    tileColumns = (columns + tileWidth - 1) / tileWidth;
+
+    // every tile is evaluated in the first generation
+    changed.assign((size_t)tileRows * tileColumns, 1);
+    nextChanged.assign(changed.size(), 0);
+    previousCells.resize(tileWidth);
+    tileHashChanges.assign(changed.size(), 0);
+    tileRowTimes.assign(tileRows, 0);
+    generation = 0;
+    evaluated = 0;
+    considered = 0;
+  }
+
+  // the change flags of a row of tiles (whether the tile differs from two generations ago)
+  const uint8_t *tileRow(const int tr) const {
+    return changed.data() + (size_t)tr * tileColumns;
+  }
+
+  // did any tile in a row of tiles change (since two generations ago)
+  bool anyChanged(const int tr) const {
+    const uint8_t *flags = tileRow(tr);
+    for (int tc = 0; tc < tileColumns; tc++) {
+      if (flags[tc]) return true;
+    }
+    return false;
+  }
+
+  // advance one generation, evaluating only the active tiles (the halo of the board must already be filled)
+  // changedAbove/changedBelow are the flags of the tile rows just above the first, and just below the last, tile row
+  void step(const PaddedBoard &board, PaddedBoard &nextGeneration, const uint8_t *changedAbove, const uint8_t *changedBelow) {
+    hashChange = 0;
+    for (int tr = 0; tr < tileRows; tr++) {
+      const uint8_t *above = tr == 0 ? changedAbove : tileRow(tr - 1);
+      const uint8_t *below = tr == tileRows - 1 ? changedBelow : tileRow(tr + 1);
+      const uint8_t *current = tileRow(tr);
+      auto start = timing ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+      for (int tc = 0; tc < tileColumns; tc++) {
+        // wraparound within the row of tiles
+        int west = (tc - 1 + tileColumns) % tileColumns;
+        int east = (tc + 1) % tileColumns;
+
+        bool active = above[west] | above[tc] | above[east] | current[west] | current[tc] | current[east] | below[west] | below[tc] | below[east];
+        nextChanged[(size_t)tr * tileColumns + tc] = active ? advanceTile(board, nextGeneration, tr, tc) : 0;
+
+        // the buffer held nothing useful before the first generation
+        if (generation == 0) nextChanged[(size_t)tr * tileColumns + tc] = 1;
+        evaluated += active;
+        if (hashing) hashChange ^= tileHashChanges[(size_t)tr * tileColumns + tc];
+      }
+
+      if (timing) tileRowTimes[tr] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    considered += changed.size();
+    changed.swap(nextChanged);
+    generation++;
+  }
+
+ private:
+  std::vector<uint8_t> changed;
+  std::vector<uint8_t> nextChanged;
+  std::vector<uint8_t> previousCells;  // a row of a tile, two generations ago
+  std::vector<uint64_t> tileHashChanges;  // the change in the hash of each tile, in the last generation it was evaluated
+
+  // update the cells of one tile - returns whether any of them differ from two generations ago
+  bool advanceTile(const PaddedBoard &board, PaddedBoard &nextGeneration, const int tr, const int tc) {
+    const int firstRow = tr * tileHeight;
+    const int lastRow = std::min(firstRow + tileHeight, rows);
+    const int firstColumn = tc * tileWidth;
+    const int width = std::min(tileWidth, columns - firstColumn);
+
+    bool tileChanged = false;
+    uint64_t &tileHashChange = tileHashChanges[(size_t)tr * tileColumns + tc];
+    tileHashChange = 0;
+    for (int row = firstRow; row < lastRow; row++) {
+      // the kernels only look one cell beyond the part of the row they update, so a tile is just an offset into the rows
+      uint8_t *next = nextGeneration.row(row) + firstColumn;
+      memcpy(previousCells.data(), next, width);
+      nextRowPadded(board.row(row - 1) + firstColumn, board.row(row) + firstColumn, board.row(row + 1) + firstColumn, next, width, rule);
+      tileChanged |= memcmp(previousCells.data(), next, width) != 0;
+      if (hashing) tileHashChange ^= hashByteChanges(board.row(row) + firstColumn, next, width, firstCellIndex + (uint64_t)row * columns + firstColumn);
+    }
+    return tileChanged;
+  }
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef BIT_BOARD_H
+#define BIT_BOARD_H
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "lifeRule.h"
+
+/*
+
+Bit-packed board:
+  - each row is stored as ceil(columns / 64) 64-bit words; bit j of word w is the cell in column 64w + j
+  - unused bits at the end of the last word of a row are always 0
+  - a whole word of cells is updated at once (bit-parallel):
+    * the west/east neighbours of a word are the word shifted by one, with the edge bit carried in from the
+      neighbouring word (or from the other end of the row, for the horizontal wraparound)
+    * the 8 neighbour words are added with bit-sliced full/half adders, which gives the neighbour count of all
+      64 cells as 4 bit-planes (1s, 2s, 4s, 8s)
+    * the rule is then evaluated with bitwise logic on the bit-planes: B3/S23 has its own formula, and any other rule matches
+      the bit-planes against each of its neighbour counts (a template on the rule, so the counts that aren't in it compile away)
+
+*/
+
+// value + carry of three bit vectors
+inline void fullAdd(const uint64_t a, const uint64_t b, const uint64_t c, uint64_t &sum, uint64_t &carry) {
+  uint64_t partial = a ^ b;
+  sum = partial ^ c;
+  carry = (a & b) | (partial & c);
+}
+
+// value + carry of two bit vectors
+inline void halfAdd(const uint64_t a, const uint64_t b, uint64_t &sum, uint64_t &carry) {
+  sum = a ^ b;
+  carry = a & b;
+}
+
+class BitBoard {
+ public:
+  int rows = 0;
+  int columns = 0;
+  int wordsPerRow = 0;
+  std::vector<uint64_t> words;
+
+  void resize(const int numRows, const int numColumns) {
+    rows = numRows;
+    columns = numColumns;
+    wordsPerRow = (numColumns + 63) / 64;
+    words.assign((size_t)rows * wordsPerRow, 0);
+  }
+
+  uint64_t *row(const int r) {
+    return words.data() + (size_t)r * wordsPerRow;
+  }
+
+  const uint64_t *row(const int r) const {
+    return words.data() + (size_t)r * wordsPerRow;
+  }
+
+  bool get(const int r, const int c) const {
+    return (row(r)[c >> 6] >> (c & 63)) & 1;
+  }
+
+  void set(const int r, const int c, const bool value) {
+    uint64_t bit = (uint64_t)1 << (c & 63);
+    if (value) {
+      row(r)[c >> 6] |= bit;
+    } else {
+      row(r)[c >> 6] &= ~bit;
+    }
+  }
+
+  // pack a board of 0/1 cells (any type that converts to bool), stored row by row
+  template <typename Cells>
+  void pack(const Cells &cells) {
+    std::fill(words.begin(), words.end(), 0);
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < columns; c++) {
+        if (cells[(size_t)r * columns + c]) set(r, c, true);
+      }
+    }
+  }
+
+  // unpack into a board of 0/1 cells, stored row by row
+  template <typename Cells>
+  void unpack(Cells &cells) const {
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < columns; c++) {
+        cells[(size_t)r * columns + c] = get(r, c);
+      }
+    }
+  }
+};
+
+// the neighbours to the west (column - 1) and east (column + 1) of every cell in word w, with horizontal wraparound
+inline void shiftWestEast(const uint64_t *row, const int w, const int wordsPerRow, const int columns, uint64_t &west, uint64_t &east) {
+  const int lastWord = wordsPerRow - 1;
+  const int lastBits = columns - 64 * lastWord;  // number of used bits in the last word
+
+  // the cell before the first one in this word (wraps to the last column of the row)
+  uint64_t prevBit = w == 0 ? (row[lastWord] >> (lastBits - 1)) & 1 : row[w - 1] >> 63;
+
+  // the cell after the last one in this word (wraps to the first column of the row)
+  uint64_t nextBit = w == lastWord ? row[0] & 1 : row[w + 1] & 1;
+  int nextPosition = w == lastWord ? lastBits - 1 : 63;
+
+  west = (row[w] << 1) | prevBit;
+  east = (row[w] >> 1) | (nextBit << nextPosition);
+}
+
+// the neighbour count of every cell in word w, as 4 bit-planes (count = ones + 2 twos + 4 fours + 8 eights)
+inline void countNeighbours(const uint64_t *above, const uint64_t *current, const uint64_t *below, const int w, const int wordsPerRow,
+                            const int columns, uint64_t &ones, uint64_t &twos, uint64_t &fours, uint64_t &eights) {
+  uint64_t aboveWest, aboveEast, west, east, belowWest, belowEast;
+  shiftWestEast(above, w, wordsPerRow, columns, aboveWest, aboveEast);
+  shiftWestEast(current, w, wordsPerRow, columns, west, east);
+  shiftWestEast(below, w, wordsPerRow, columns, belowWest, belowEast);
+
+  // add each row of neighbours: above and below have 3 (2 bit sum), the current row has 2 (2 bit sum)
+  uint64_t aboveOnes, aboveTwos, belowOnes, belowTwos, currentOnes, currentTwos;
+  fullAdd(aboveWest, above[w], aboveEast, aboveOnes, aboveTwos);
+  fullAdd(belowWest, below[w], belowEast, belowOnes, belowTwos);
+  halfAdd(west, east, currentOnes, currentTwos);
+
+  // add the three 2 bit sums
+  uint64_t onesCarry, twosSum, twosCarry, twosCarry2;
+  fullAdd(aboveOnes, belowOnes, currentOnes, ones, onesCarry);
+  fullAdd(aboveTwos, belowTwos, currentTwos, twosSum, twosCarry);
+  halfAdd(twosSum, onesCarry, twos, twosCarry2);
+  halfAdd(twosCarry, twosCarry2, fours, eights);
+}
+
+// compute the next generation of a row (B3/S23), given the rows above and below it
+inline void nextRowB3S23(const uint64_t *above, const uint64_t *current, const uint64_t *below, uint64_t *next, const int wordsPerRow,
+                         const int columns) {
+  for (int w = 0; w < wordsPerRow; w++) {
+    uint64_t ones, twos, fours, eights;
+    countNeighbours(above, current, below, w, wordsPerRow, columns, ones, twos, fours, eights);
+
+    // alive next generation: exactly 3 neighbours, or alive with exactly 2 (a count of 8 has no 2s bit, so eights can be ignored)
+    next[w] = twos & ~fours & (ones | current[w]);
+  }
+
+  // keep the unused bits of the last word at 0
+  const int lastBits = columns - 64 * (wordsPerRow - 1);
+  if (lastBits < 64) next[wordsPerRow - 1] &= ((uint64_t)1 << lastBits) - 1;
+}
+
+// the cells (of a word) whose neighbour count is n
+inline uint64_t countEquals(const int n, const uint64_t ones, const uint64_t twos, const uint64_t fours, const uint64_t eights) {
+  return ((n & 1) ? ones : ~ones) & ((n & 2) ? twos : ~twos) & ((n & 4) ? fours : ~fours) & ((n & 8) ? eights : ~eights);
+}
+
+// apply a rule (given as birth and survival masks) to a word of cells, given the bit-planes of their neighbour counts
+inline uint64_t applyRule(const uint16_t birth, const uint16_t survival, const uint64_t current, const uint64_t ones, const uint64_t twos,
+                          const uint64_t fours, const uint64_t eights) {
+  uint64_t born = 0, survive = 0;
+  for (int n = 0; n <= 8; n++) {
+    if ((birth >> n) & 1) born |= countEquals(n, ones, twos, fours, eights);
+    if ((survival >> n) & 1) survive |= countEquals(n, ones, twos, fours, eights);
+  }
+  return (born & ~current) | (survive & current);
+}
+
+// compute the next generation of a row under a rule - Rule is a rule mask (see lifeRule.h), or runtimeRule to use ruleAtRuntime
+template <uint32_t Rule>
+inline void nextRowRule(const uint64_t *above, const uint64_t *current, const uint64_t *below, uint64_t *next, const int wordsPerRow,
+                        const int columns, const uint32_t ruleAtRuntime = conwayRule) {
+  const uint32_t rule = Rule == runtimeRule ? ruleAtRuntime : Rule;
+  const uint16_t birth = rule & 0x1FF;
+  const uint16_t survival = rule >> 9;
+
+  for (int w = 0; w < wordsPerRow; w++) {
+    uint64_t ones, twos, fours, eights;
+    countNeighbours(above, current, below, w, wordsPerRow, columns, ones, twos, fours, eights);
+    next[w] = applyRule(birth, survival, current[w], ones, twos, fours, eights);
+  }
+
+  // keep the unused bits of the last word at 0
+  const int lastBits = columns - 64 * (wordsPerRow - 1);
+  if (lastBits < 64) next[wordsPerRow - 1] &= ((uint64_t)1 << lastBits) - 1;
+}
+
+// compute the next generation of a row under any rule - the common rules use their compiled versions
+inline void nextRowBits(const uint64_t *above, const uint64_t *current, const uint64_t *below, uint64_t *next, const int wordsPerRow,
+                        const int columns, const LifeRule &rule) {
+  switch (rule.mask()) {
+    case conwayRule:
+      nextRowB3S23(above, current, below, next, wordsPerRow, columns);
+      break;
+    case highLifeRule:
+      nextRowRule<highLifeRule>(above, current, below, next, wordsPerRow, columns);
+      break;
+    case dayAndNightRule:
+      nextRowRule<dayAndNightRule>(above, current, below, next, wordsPerRow, columns);
+      break;
+    case seedsRule:
+      nextRowRule<seedsRule>(above, current, below, next, wordsPerRow, columns);
+      break;
+    default:
+      nextRowRule<runtimeRule>(above, current, below, next, wordsPerRow, columns, rule.mask());
+  }
+}
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef BOARD_FILE_H
+#define BOARD_FILE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+/*
+
+Boards that don't need a single process to hold them:
+  - counter-based initial boards: the initial value of a cell is a hash of (seed, global cell index), so any process can generate
+    any part of the board on its own, and the board is the same for any number of processes
+  - board hashes: every cell index has a random 64-bit key, and the hash of a board is the XOR of the keys of its live cells
+    * the hash of the whole board is the XOR of the hashes of its parts, so each process hashes its own rows, and one reduction
+      gives the hash of the board - correctness can be checked without gathering the board
+    * a cell that changes flips its key in or out of the hash, so the hash of the next generation only needs the changed cells
+  - word hashes (for cycle detection, where a hash is only compared with the hashes of the same run): the same, but with a key
+    for each word of cells and its value (Zobrist hashing, with words as the pieces), so a changed word costs two keys, however
+    many of its cells changed - a hash that starts at 0 and is only ever updated is the hash relative to the initial board
+  - binary board files: a 24 byte header ("GOLBOARD", then the rows and columns as 64-bit integers), then the rows, 1 bit per cell
+    (bit j of byte b is column 8b + j), each row padded to a whole number of bytes
+    * each row is at a known offset, so processes can write their own rows (collectively, with MPI-IO)
+
+*/
+
+// the splitmix64 finaliser: a cheap, well mixed hash of a 64-bit value
+inline uint64_t mix64(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+// the initial value of a cell of a counter-based board (alive with probability 0.5)
+inline bool counterCell(const uint64_t seed, const uint64_t index) {
+  return mix64(mix64(seed) ^ index) >> 63;
+}
+
+// the random key of a cell, for board hashes
+inline uint64_t cellKey(const uint64_t index) {
+  return mix64(index ^ 0x5851F42D4C957F2DULL);
+}
+
+// the hash of count cells (0/1), the first of which is at firstIndex on the board
+template <typename Cells>
+uint64_t hashCells(const Cells &cells, const size_t count, const uint64_t firstIndex) {
+  uint64_t hash = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (cells[i]) hash ^= cellKey(firstIndex + i);
+  }
+  return hash;
+}
+
+// the change in the hash of count cells (0/1) from one generation to the next - only the cells that changed are hashed
+template <typename Cells>
+uint64_t hashCellChanges(const Cells &before, const Cells &after, const size_t count, const uint64_t firstIndex) {
+  uint64_t change = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (before[i] != after[i]) change ^= cellKey(firstIndex + i);
+  }
+  return change;
+}
+
+// the key of a word of cells (whose first cell is at index), given its value - only a multiply and a shift per half, since
+// it's computed for every word that changes, and a collision only costs a compare (see cycleDetector.h)
+inline uint64_t wordKey(const uint64_t index, const uint64_t value) {
+  uint64_t x = (index * 0x9E3779B97F4A7C15ULL) ^ value;
+  x *= 0xBF58476D1CE4E5B9ULL;
+  return x ^ (x >> 31);
+}
+
+// the change in a word hash of count cells (0/1 bytes) from one generation to the next - each 8 bytes are a word
+inline uint64_t hashByteChanges(const uint8_t *before, const uint8_t *after, const size_t count, const uint64_t firstIndex) {
+  uint64_t change = 0;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    uint64_t beforeWord, afterWord;
+    memcpy(&beforeWord, before + i, 8);
+    memcpy(&afterWord, after + i, 8);
+
+    // no branch: the keys of a word that didn't change cancel out, and while the board is settling, which words change is too
+    // random to predict
+    change ^= wordKey(firstIndex + i, beforeWord) ^ wordKey(firstIndex + i, afterWord);
+  }
+
+  // the rest of the cells are a shorter word
+  if (i < count) {
+    uint64_t beforeWord = 0, afterWord = 0;
+    const size_t length = count - i < 8 ? count - i : 8;
+    memcpy(&beforeWord, before + i, length);
+    memcpy(&afterWord, after + i, length);
+    change ^= wordKey(firstIndex + i, beforeWord) ^ wordKey(firstIndex + i, afterWord);
+  }
+  return change;
+}
+
+// the same for a bit-packed row (64 cells per word)
+inline uint64_t hashBitChanges(const uint64_t *before, const uint64_t *after, const int words, const uint64_t firstIndex) {
+  uint64_t change = 0;
+  for (int w = 0; w < words; w++) {
+    if (before[w] != after[w]) change ^= wordKey(firstIndex + 64 * w, before[w]) ^ wordKey(firstIndex + 64 * w, after[w]);
+  }
+  return change;
+}
+
+const char boardFileMagic[8] = {'G', 'O', 'L', 'B', 'O', 'A', 'R', 'D'};
+const int boardFileHeaderSize = 24;
+
+// the bytes of a row in a board file
+inline size_t boardFileRowBytes(const int64_t columns) {
+  return (columns + 7) / 8;
+}
+
+inline void boardFileHeader(const int64_t rows, const int64_t columns, uint8_t header[boardFileHeaderSize]) {
+  memcpy(header, boardFileMagic, 8);
+  memcpy(header + 8, &rows, 8);
+  memcpy(header + 16, &columns, 8);
+}
+
+// pack rows of 0/1 cells (stored row by row) into the rows of a board file
+template <typename Cells>
+void packBoardRows(const Cells &cells, const int rows, const int columns, std::vector<uint8_t> &bytes) {
+  const size_t rowBytes = boardFileRowBytes(columns);
+  bytes.assign(rows * rowBytes, 0);
+  for (int r = 0; r < rows; r++) {
+    for (int c = 0; c < columns; c++) {
+      if (cells[(size_t)r * columns + c]) bytes[r * rowBytes + c / 8] |= 1 << (c % 8);
+    }
+  }
+}
+
+#endif
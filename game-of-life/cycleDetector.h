@@ -0,0 +1,91 @@
+#ifndef CYCLE_DETECTOR_H
+#define CYCLE_DETECTOR_H
+
+#include <stdint.h>
+
+#include <functional>
+#include <vector>
+
+/*
+
+Cycle detection (for early termination):
+  - random boards settle into still lifes and oscillators, after which every generation repeats one from p generations ago
+  - the hash of each generation (see boardFile.h - the game updates it incrementally, from the cells that changed, starting from
+    0 for the initial board) goes into a ring of the last maxPeriod hashes, and a hash that is already in the ring, p generations
+    ago, makes p a candidate period
+  - hashes can collide, so a candidate is confirmed with a full compare: the board is saved, and compared with the board p
+    generations later - if they are the same, the game repeats with period p from the saved generation on (it's deterministic)
+  - once a cycle is confirmed, the whole periods before the target generation are skipped: only the remaining
+    (target - generation) % p generations are played
+  - in the MPI version, the hashes are of the whole board (one reduction per generation), and the compare is collective, so every
+    process finds the same cycle at the same generation
+
+*/
+
+const int defaultMaxPeriod = 64;
+
+template <typename Board>
+class CycleDetector {
+ public:
+  // the cycle that was found (period 0 if none was)
+  int period = 0;
+  int cycleStart = 0;   // the first generation that is known to repeat
+  int confirmedAt = 0;  // the generation the cycle was confirmed at
+  int skipped = 0;      // the generations that weren't played
+
+  // same(a, b): are two boards the same (every process must agree, in the MPI version)
+  CycleDetector(const int targetGeneration, std::function<bool(const Board &, const Board &)> same, const int maxPeriod = defaultMaxPeriod)
+      : targetGeneration(targetGeneration), same(same), hashes(maxPeriod) {
+  }
+
+  // call after each generation, with the hash of the board - returns the number of generations the game can skip
+  int observe(const int generation, const uint64_t hash, const Board &board) {
+    if (period > 0) return 0;
+
+    const int maxPeriod = hashes.size();
+    if (candidatePeriod > 0 && generation == candidateGeneration + candidatePeriod) {
+      if (hash == candidateHash && same(saved, board)) {
+        period = candidatePeriod;
+        cycleStart = candidateGeneration;
+        confirmedAt = generation;
+        skipped = (targetGeneration - generation) / period * period;
+        saved = Board();
+        return skipped;
+      }
+
+      // a collision, or the board is still settling
+      candidatePeriod = 0;
+    }
+
+    // the shortest period whose hashes match (the longer ones are multiples of it, or collisions)
+    if (candidatePeriod == 0) {
+      for (int p = 1; p <= maxPeriod && p <= generation; p++) {
+        if (hashes[(generation - p) % maxPeriod] != hash) continue;
+
+        // it's only worth confirming if there is a whole period left to skip after it
+        if (generation + 2 * p <= targetGeneration) {
+          candidatePeriod = p;
+          candidateGeneration = generation;
+          candidateHash = hash;
+          saved = board;
+        }
+        break;
+      }
+    }
+
+    hashes[generation % maxPeriod] = hash;
+    return 0;
+  }
+
+ private:
+  const int targetGeneration;
+  std::function<bool(const Board &, const Board &)> same;
+  std::vector<uint64_t> hashes;  // the ring: the hash of generation g is at g % maxPeriod (generation 0's is 0)
+
+  int candidatePeriod = 0;
+  int candidateGeneration = 0;
+  uint64_t candidateHash = 0;
+  Board saved;
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <vector>
+
+#include "boardFile.h"
+#include "cycleDetector.h"
+#include "lifeRule.h"
+#include "paddedBoard.h"
+
+/*
+
+Ensemble mode (many small, independent boards - one per seed):
+  - a small board is latency bound when its rows are split between processes (a halo exchange per generation for very little
+    work), and a launch per board pays for the start up every time - instead, the boards are the unit of work: each worker
+    (a thread, or an MPI process) takes the next seed from a shared counter (a work queue), plays its whole board, and takes
+    another one, so the boards are spread evenly even when some settle (and stop early, with cycle detection) much sooner
+  - a board only needs its seed: it starts from the counter-based initialisation (see boardFile.h), so it's the same board
+    whichever worker plays it, and the same as a single run with --init counter
+  - each board is played with the padded engine (its two buffers are reused from board to board), and summarised by its final
+    population, its hash, and the cycle it settled into (with cycle detection)
+  - the headline figure is boards per second
+
+*/
+
+struct BoardSummary {
+  int64_t seed;
+  int64_t population;   // the live cells of the final board
+  uint64_t hash;        // the hash of the final board (the same as a single run's final hash)
+  int64_t period;       // the period of the cycle found (0 if none was, or cycle detection is off)
+  int64_t cycleStart;   // the first generation of the cycle
+};
+
+class EnsembleBoard {
+ public:
+  LifeRule rule;
+  bool detectCycles = false;
+
+  void resize(const int rows, const int columns) {
+    board.resize(rows, columns);
+    nextGeneration.resize(rows, columns);
+  }
+
+  // play the board of a seed, and summarise it
+  BoardSummary play(const int64_t seed, const int generations) {
+    const int rows = board.rows, columns = board.columns;
+    for (int r = 0; r < rows; r++) {
+      uint8_t *cells = board.row(r);
+      for (int c = 0; c < columns; c++) cells[c] = counterCell(seed, (uint64_t)r * columns + c);
+    }
+
+    CycleDetector<PaddedBoard> detector(generations, [](const PaddedBoard &a, const PaddedBoard &b) { return a.sameCells(b); });
+    uint64_t hash = 0;
+
+    for (int iter = 0; iter < generations; iter++) {
+      board.fillRowHalo();
+      board.fillColumnHalo();
+      for (int row = 0; row < rows; row++) {
+        nextRowPadded(board.row(row - 1), board.row(row), board.row(row + 1), nextGeneration.row(row), columns, rule);
+        if (detectCycles) hash ^= hashByteChanges(board.row(row), nextGeneration.row(row), columns, (uint64_t)row * columns);
+      }
+      board.cells.swap(nextGeneration.cells);
+      if (detectCycles) iter += detector.observe(iter + 1, hash, board);
+    }
+
+    BoardSummary summary = {seed, 0, 0, detector.period, detector.cycleStart};
+    for (int r = 0; r < rows; r++) {
+      const uint8_t *cells = board.row(r);
+      for (int c = 0; c < columns; c++) summary.population += cells[c];
+      summary.hash ^= hashCells(cells, columns, (uint64_t)r * columns);
+    }
+    return summary;
+  }
+
+ private:
+  PaddedBoard board, nextGeneration;
+};
+
+// write the summaries, a board per line: "<seed> <population> <hash> <period> <cycle start>" (in the order of the seeds)
+inline void writeEnsembleSummaries(std::ostream &out, std::vector<BoardSummary> summaries) {
+  std::sort(summaries.begin(), summaries.end(), [](const BoardSummary &a, const BoardSummary &b) { return a.seed < b.seed; });
+  out << "# seed population hash period cycle-start\n";
+  char line[128];
+  for (const BoardSummary &summary : summaries) {
+    snprintf(line, sizeof(line), "%lld %lld %016llx %lld %lld\n", (long long)summary.seed, (long long)summary.population,
+             (unsigned long long)summary.hash, (long long)summary.period, (long long)summary.cycleStart);
+    out << line;
+  }
+}
+
+// the statistics of an ensemble: the population range, a hash of every final board, and how many boards settled into each period
+class EnsembleStatistics {
+ public:
+  int64_t boards = 0;
+  int64_t minPopulation = 0, maxPopulation = 0;
+  double meanPopulation = 0;
+  uint64_t hash = 0;                   // a hash of every board's seed and final hash (the same however the boards were spread)
+  std::map<int64_t, int64_t> periods;  // period -> boards
+
+  explicit EnsembleStatistics(const std::vector<BoardSummary> &summaries) {
+    boards = summaries.size();
+    for (size_t i = 0; i < summaries.size(); i++) {
+      const BoardSummary &summary = summaries[i];
+      minPopulation = i == 0 ? summary.population : std::min(minPopulation, summary.population);
+      maxPopulation = std::max(maxPopulation, summary.population);
+      meanPopulation += (double)summary.population / boards;
+      hash ^= mix64(summary.hash ^ (uint64_t)summary.seed);
+      if (summary.period > 0) periods[summary.period]++;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,459 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+/*
+
+General Idea (HashLife):
+  - the board is a quadtree: a node of level k is a 2^k x 2^k square, made of 4 children of level k - 1 (level 0 is a single cell)
+  - nodes are hash-consed (canonical): a node with the same 4 children is only ever created once, so repeated structure is stored once
+  - the result of a node of level k is its centre square (level k - 1) after 2^j generations (j <= k - 2)
+    * it only depends on the node, so it is memoised - the same region is never simulated twice
+    * it is computed recursively from 9 overlapping sub-squares of level k - 1, in two halves of 2^(j - 1) generations
+      (when j < k - 2, the first half takes the centre of each sub-square instead of advancing it)
+  - our board is a torus, but HashLife works on the infinite plane, so for each jump of 2^j generations:
+    * the board is tiled periodically over the plane, and a node big enough to hold the board (plus a margin of 2^j
+      cells on every side, which is as far as information can travel) is built from the tiling
+    * the result of that node is the board after 2^j generations (a periodic pattern stays periodic)
+  - memory is bounded: when the node table grows past a limit (between jumps), a garbage collection keeps only the nodes
+    reachable from the last universe (and their memoised results), and if that is still too much, everything is evicted
+    * the limit is soft: a jump holds node ids on the stack of its recursion, so nodes can't be moved (or evicted) until it
+      finishes, and a single jump can grow the table past the limit - a smaller --max-step makes each jump (and so the
+      overshoot) smaller
+
+*/
+
+const string outputFileName = "hashlife-output.txt";
+const int averageIterations = 5;
+const int64_t minMaxNodes = 1 << 10;  // below this, a garbage collection would run after nearly every jump
+
+int totalRows;
+int totalColumns;
+
+// convert a 2d coordinate to a 1d value
+int convertToIndex(const int row, const int column) {
+  return row * totalColumns + column;
+}
+
+// print the 2d board
+void printBoard(ofstream &file, const vector<bool> &board) {
+  for (int i = 0; i < board.size(); i++) {
+    file << board[i];
+    if ((i + 1) % totalColumns == 0) {
+      file << "\n";
+    }
+  }
+}
+
+typedef uint32_t node_id;
+
+typedef struct {
+  int level;
+  node_id nw, ne, sw, se;
+  bool empty;  // no live cells
+} node;
+
+// the 4 children of a node - used to find the canonical node
+typedef struct {
+  node_id nw, ne, sw, se;
+} children;
+
+struct ChildrenHash {
+  size_t operator()(const children &c) const {
+    uint64_t h = c.nw;
+    h = h * 0x9E3779B97F4A7C15ULL + c.ne;
+    h = h * 0x9E3779B97F4A7C15ULL + c.sw;
+    h = h * 0x9E3779B97F4A7C15ULL + c.se;
+    return h ^ (h >> 29);
+  }
+};
+
+struct ChildrenEqual {
+  bool operator()(const children &a, const children &b) const {
+    return a.nw == b.nw && a.ne == b.ne && a.sw == b.sw && a.se == b.se;
+  }
+};
+
+class HashLife {
+ public:
+  // statistics
+  uint64_t resultHits = 0;
+  uint64_t resultMisses = 0;
+  int collections = 0;
+
+  explicit HashLife(const int64_t maxNodes) : maxNodes(maxNodes) {
+    reset();
+  }
+
+  size_t numNodes() const {
+    return nodes.size();
+  }
+
+  // the canonical node with these children
+  node_id join(const node_id nw, const node_id ne, const node_id sw, const node_id se) {
+    children key = {nw, ne, sw, se};
+    auto it = table.find(key);
+    if (it != table.end()) return it->second;
+
+    node n = {nodes[nw].level + 1, nw, ne, sw, se, nodes[nw].empty && nodes[ne].empty && nodes[sw].empty && nodes[se].empty};
+    nodes.push_back(n);
+    table[key] = nodes.size() - 1;
+    return nodes.size() - 1;
+  }
+
+  // the centre of a node, one level down, after 2^j generations (j <= level - 2)
+  node_id advance(const node_id id, const int j) {
+    const node n = nodes[id];
+
+    // nothing is ever born in an empty region
+    if (n.empty) return emptyNode(n.level - 1);
+
+    uint64_t key = (uint64_t)id << 6 | j;
+    auto it = results.find(key);
+    if (it != results.end()) {
+      resultHits++;
+      return it->second;
+    }
+    resultMisses++;
+
+    node_id result;
+    if (n.level == 2) {
+      result = advanceBase(id);
+    } else {
+      const node nw = nodes[n.nw], ne = nodes[n.ne], sw = nodes[n.sw], se = nodes[n.se];
+
+      // the 9 overlapping sub-squares (level - 1)
+      node_id sub[3][3];
+      sub[0][0] = n.nw;
+      sub[0][1] = join(nw.ne, ne.nw, nw.se, ne.sw);
+      sub[0][2] = n.ne;
+      sub[1][0] = join(nw.sw, nw.se, sw.nw, sw.ne);
+      sub[1][1] = join(nw.se, ne.sw, sw.ne, se.nw);
+      sub[1][2] = join(ne.sw, ne.se, se.nw, se.ne);
+      sub[2][0] = n.sw;
+      sub[2][1] = join(sw.ne, se.nw, sw.se, se.sw);
+      sub[2][2] = n.se;
+
+      // first half: advance each sub-square (for a full step), or just take its centre
+      const bool fullStep = j == n.level - 2;
+      node_id half[3][3];
+      for (int r = 0; r < 3; r++) {
+        for (int c = 0; c < 3; c++) {
+          half[r][c] = fullStep ? advance(sub[r][c], n.level - 3) : centre(sub[r][c]);
+        }
+      }
+
+      // second half: combine into 4 overlapping squares, and advance each of them
+      const int secondStep = fullStep ? n.level - 3 : j;
+      result = join(advance(join(half[0][0], half[0][1], half[1][0], half[1][1]), secondStep),
+                    advance(join(half[0][1], half[0][2], half[1][1], half[1][2]), secondStep),
+                    advance(join(half[1][0], half[1][1], half[2][0], half[2][1]), secondStep),
+                    advance(join(half[1][1], half[1][2], half[2][1], half[2][2]), secondStep));
+    }
+
+    results[key] = result;
+    return result;
+  }
+
+  // build the node of the given level whose top left corner is at (row, column) of the periodically tiled board
+  node_id buildPeriodic(const vector<bool> &board, const int level, const int64_t row, const int64_t column) {
+    int r = ((row % totalRows) + totalRows) % totalRows;
+    int c = ((column % totalColumns) + totalColumns) % totalColumns;
+
+    if (level == 0) return board[convertToIndex(r, c)] ? 1 : 0;
+
+    // the same offset into the tiling always gives the same node
+    uint64_t key = (uint64_t)level << 58 | (uint64_t)r << 29 | (uint64_t)c;
+    auto it = built.find(key);
+    if (it != built.end()) return it->second;
+
+    const int64_t half = (int64_t)1 << (level - 1);
+    node_id id = join(buildPeriodic(board, level - 1, row, column), buildPeriodic(board, level - 1, row, column + half),
+                      buildPeriodic(board, level - 1, row + half, column), buildPeriodic(board, level - 1, row + half, column + half));
+    built[key] = id;
+    return id;
+  }
+
+  // write the cells of a node (top left corner at (row, column)) that fall inside the board
+  void flatten(const node_id id, const int64_t row, const int64_t column, vector<bool> &board) {
+    const node &n = nodes[id];
+    const int64_t size = (int64_t)1 << n.level;
+    if (row >= totalRows || column >= totalColumns) return;
+
+    if (n.level == 0) {
+      board[convertToIndex(row, column)] = id == 1;
+      return;
+    }
+
+    if (n.empty) {
+      // fill the visible part with dead cells
+      for (int64_t r = row; r < min(row + size, (int64_t)totalRows); r++) {
+        for (int64_t c = column; c < min(column + size, (int64_t)totalColumns); c++) {
+          board[convertToIndex(r, c)] = false;
+        }
+      }
+      return;
+    }
+
+    const int64_t half = size / 2;
+    flatten(n.nw, row, column, board);
+    flatten(n.ne, row, column + half, board);
+    flatten(n.sw, row + half, column, board);
+    flatten(n.se, row + half, column + half, board);
+  }
+
+  // forget the nodes built from the last tiling
+  void finishBuild() {
+    built.clear();
+  }
+
+  // bounded memory: keep what is reachable from the root (with its memoised results), or evict everything
+  // only safe between jumps - no node ids may be held anywhere else
+  void collectGarbage(const node_id root) {
+    if ((int64_t)nodes.size() <= maxNodes) return;
+    collections++;
+
+    // mark the root, its descendants, and the results memoised for them
+    vector<bool> marked(nodes.size(), false);
+    vector<node_id> stack(1, root);
+    while (!stack.empty()) {
+      node_id id = stack.back();
+      stack.pop_back();
+      if (marked[id]) continue;
+      marked[id] = true;
+
+      const node &n = nodes[id];
+      if (n.level > 0) {
+        stack.push_back(n.nw);
+        stack.push_back(n.ne);
+        stack.push_back(n.sw);
+        stack.push_back(n.se);
+      }
+      for (int j = 0; j + 2 <= n.level; j++) {
+        auto it = results.find((uint64_t)id << 6 | j);
+        if (it != results.end()) stack.push_back(it->second);
+      }
+    }
+
+    size_t live = 0;
+    for (bool m : marked) live += m;
+    if ((int64_t)live > maxNodes / 2) {
+      // the live set is too big to be worth keeping
+      reset();
+      return;
+    }
+
+    // compact the table - children always come before their parents, so ids can be remapped in order
+    vector<node_id> remap(nodes.size());
+    vector<node> compacted;
+    compacted.reserve(live);
+    for (node_id id = 0; id < nodes.size(); id++) {
+      if (!marked[id]) continue;
+      node n = nodes[id];
+      if (n.level > 0) {
+        n.nw = remap[n.nw];
+        n.ne = remap[n.ne];
+        n.sw = remap[n.sw];
+        n.se = remap[n.se];
+      }
+      remap[id] = compacted.size();
+      compacted.push_back(n);
+    }
+
+    unordered_map<uint64_t, node_id> compactedResults;
+    for (const auto &entry : results) {
+      node_id id = entry.first >> 6;
+      if (marked[id] && marked[entry.second]) {
+        compactedResults[(uint64_t)remap[id] << 6 | (entry.first & 63)] = remap[entry.second];
+      }
+    }
+
+    nodes.swap(compacted);
+    results.swap(compactedResults);
+    rebuildTable();
+    emptyNodes.clear();
+  }
+
+ private:
+  const int64_t maxNodes;
+  vector<node> nodes;
+  unordered_map<children, node_id, ChildrenHash, ChildrenEqual> table;
+  unordered_map<uint64_t, node_id> results;  // (node, j) -> centre after 2^j generations
+  unordered_map<uint64_t, node_id> built;    // (level, row, column) of the tiling -> node
+  vector<node_id> emptyNodes;                // the empty node of each level
+
+  void reset() {
+    nodes.clear();
+    table.clear();
+    results.clear();
+    built.clear();
+    emptyNodes.clear();
+
+    // the two leaves: 0 is a dead cell, 1 is a live cell
+    nodes.push_back({0, 0, 0, 0, 0, true});
+    nodes.push_back({0, 0, 0, 0, 0, false});
+  }
+
+  void rebuildTable() {
+    table.clear();
+    for (node_id id = 2; id < nodes.size(); id++) {
+      const node &n = nodes[id];
+      table[{n.nw, n.ne, n.sw, n.se}] = id;
+    }
+  }
+
+  node_id emptyNode(const int level) {
+    while (emptyNodes.size() <= level) {
+      node_id child = emptyNodes.empty() ? 0 : emptyNodes.back();
+      emptyNodes.push_back(emptyNodes.empty() ? 0 : join(child, child, child, child));
+    }
+    return emptyNodes[level];
+  }
+
+  node_id centre(const node_id id) {
+    const node &n = nodes[id];
+    return join(nodes[n.nw].se, nodes[n.ne].sw, nodes[n.sw].ne, nodes[n.se].nw);
+  }
+
+  // a 4x4 node: simulate one generation of its centre 2x2 cells directly
+  node_id advanceBase(const node_id id) {
+    // read the 16 cells
+    bool cells[4][4];
+    const node &n = nodes[id];
+    node_id quadrants[2][2] = {{n.nw, n.ne}, {n.sw, n.se}};
+    for (int qr = 0; qr < 2; qr++) {
+      for (int qc = 0; qc < 2; qc++) {
+        const node &q = nodes[quadrants[qr][qc]];
+        cells[2 * qr][2 * qc] = q.nw == 1;
+        cells[2 * qr][2 * qc + 1] = q.ne == 1;
+        cells[2 * qr + 1][2 * qc] = q.sw == 1;
+        cells[2 * qr + 1][2 * qc + 1] = q.se == 1;
+      }
+    }
+
+    node_id next[2][2];
+    for (int r = 1; r <= 2; r++) {
+      for (int c = 1; c <= 2; c++) {
+        int numAlive = 0;
+        for (int i = -1; i <= 1; i++) {
+          for (int j = -1; j <= 1; j++) {
+            if (i != 0 || j != 0) numAlive += cells[r + i][c + j];
+          }
+        }
+        next[r - 1][c - 1] = (numAlive == 3 || (cells[r][c] && numAlive == 2)) ? 1 : 0;
+      }
+    }
+
+    return join(next[0][0], next[0][1], next[1][0], next[1][1]);
+  }
+};
+
+// the smallest level whose square is at least this big
+int levelFor(const int64_t size) {
+  int level = 0;
+  while (((int64_t)1 << level) < size) level++;
+  return level;
+}
+
+// advance the (toroidal) board by a number of generations, in jumps of up to 2^maxStepLog2
+void playHashLife(HashLife &life, vector<bool> &board, int64_t generations, const int maxStepLog2) {
+  while (generations > 0) {
+    // the largest power of two that fits in what is left
+    int j = 0;
+    while (j < maxStepLog2 && ((int64_t)2 << j) <= generations) j++;
+
+    // the result (centre half) must cover the board, and the margin around it must cover 2^j generations
+    const int level = max(levelFor(max(totalRows, totalColumns)) + 1, j + 2);
+    const int64_t margin = (int64_t)1 << (level - 2);
+
+    node_id root = life.buildPeriodic(board, level, -margin, -margin);
+    life.finishBuild();
+
+    node_id result = life.advance(root, j);
+    life.flatten(result, 0, 0, board);
+
+    generations -= (int64_t)1 << j;
+    life.collectGarbage(root);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  int maxStepLog2 = 62;
+  int64_t maxNodes = (int64_t)1 << 24;
+  bool usageError = argc < 5;
+  for (int i = 5; i < argc && !usageError; i++) {
+    string option(argv[i]);
+    if (option == "--max-step" && i + 1 < argc) {
+      maxStepLog2 = atoi(argv[++i]);
+      usageError = maxStepLog2 < 0 || maxStepLog2 > 62;
+    } else if (option == "--max-nodes" && i + 1 < argc) {
+      maxNodes = atoll(argv[++i]);
+      usageError = maxNodes < minMaxNodes;
+    } else {
+      usageError = true;
+    }
+  }
+
+  if (usageError) {
+    printf("Usage: %s <rows> <columns> <seed> <generation> <OPTIONAL: --max-step <log2 of the largest jump, 0-62>> "
+           "<OPTIONAL: --max-nodes <node limit, checked between jumps, at least %lld>>\n",
+           argv[0], (long long)minMaxNodes);
+    return 0;
+  }
+
+  // get the arguments
+  totalRows = atoi(argv[1]);
+  totalColumns = atoi(argv[2]);
+  int seed = atoi(argv[3]);
+  int64_t generation = atoll(argv[4]);
+
+  // Create and open a text file
+  ofstream outputFile(outputFileName);
+
+  u_int64_t runTime = 0;
+  HashLife life(maxNodes);
+
+  for (int _ = 0; _ < averageIterations; _++) {
+    // create our board
+    vector<bool> board;
+    board.resize(totalRows * totalColumns);
+
+    // initialise the board using the seed
+    srand(seed);
+    for (int i = 0; i < board.size(); i++) {
+      bool value = ((double)rand() / RAND_MAX) >= 0.5 ? true : false;
+      board[i] = value;
+    }
+
+    // print the initial board
+    outputFile << "\n";
+    printBoard(outputFile, board);
+
+    auto startTime = chrono::high_resolution_clock::now();
+    playHashLife(life, board, generation, maxStepLog2);
+    auto endTime = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::microseconds>(endTime - startTime);
+    runTime += duration.count();
+
+    // print the final board
+    outputFile << "\n";
+    printBoard(outputFile, board);
+  }
+
+  printf("HashLife average run time: %.2fms\n", (double)runTime / 1000 / averageIterations);
+  printf("HashLife nodes: %zu, memoised results hit/missed: %llu/%llu, garbage collections: %d\n", life.numNodes(),
+         (unsigned long long)life.resultHits, (unsigned long long)life.resultMisses, life.collections);
+
+  // close the file
+  outputFile.close();
+
+  return 0;
+}
@@ -0,0 +1,359 @@
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paddedBoard.h"
+
+using namespace std;
+
+/*
+
+General Idea (hybrid MPI + threads):
+  - one process per node (or socket), each with a strip of rows on a padded byte board (see paddedBoard.h), and a team of
+    threads that share the strip - so there are fewer processes, and fewer (but larger) halo messages per generation than
+    with one process per core
+  - each generation, a driver thread posts the halo exchange (non-blocking, straight into the padding), then computes interior
+    rows with the other threads (which don't need the halo), checking on the messages between chunks of rows; once a halo row
+    has arrived, the driver computes the boundary row next to it
+  - the interior rows are handed out in chunks from a shared counter, so the driver takes fewer while it is busy with the halo
+  - thread levels:
+    * funneled (MPI_THREAD_FUNNELED): the main thread drives both halo rows, and is the only thread that calls MPI
+    * multiple (MPI_THREAD_MULTIPLE): the first thread drives the exchange with the previous process, and the last thread the
+      exchange with the next process, at the same time
+  - whoever computes a row also fills its column halo (the wraparound within the row), and the threads meet at a barrier
+    at the end of each generation, before the buffers swap roles
+
+*/
+
+const string outputFileName = "hybrid-output.txt";
+const int averageIterations = 5;
+
+// the interior rows are handed out this many at a time
+const int chunkRows = 8;
+
+int totalRows;
+int totalColumns;
+
+// print the 2d board
+void printBoard(ofstream &file, const vector<uint8_t> &board) {
+  for (int i = 0; i < board.size(); i++) {
+    file << (int)board[i];
+    if ((i + 1) % totalColumns == 0) {
+      file << "\n";
+    }
+  }
+}
+
+// the first row of process i, when total rows are split into parts strips (the first total % parts strips get an extra one)
+int stripStart(const int i, const int total, const int parts) {
+  return i * (total / parts) + min(i, total % parts);
+}
+
+// a barrier for a team of threads - the last thread to arrive runs onComplete before any thread leaves
+class ThreadBarrier {
+ public:
+  explicit ThreadBarrier(const int numThreads) : numThreads(numThreads) {
+  }
+
+  template <typename OnComplete>
+  void wait(OnComplete onComplete) {
+    unique_lock<mutex> guard(lock);
+    const int phase = this->phase;
+    if (++arrived == numThreads) {
+      onComplete();
+      arrived = 0;
+      this->phase++;
+      released.notify_all();
+      return;
+    }
+    released.wait(guard, [&] { return this->phase != phase; });
+  }
+
+ private:
+  const int numThreads;
+  int arrived = 0;
+  int phase = 0;
+  mutex lock;
+  condition_variable released;
+};
+
+class HybridGame {
+ public:
+  // statistics (over every run)
+  double haloWaitTime = 0;  // the time the driver threads spent waiting for halo rows, with nothing else to compute
+
+  HybridGame(const int rank, const int numProcs, const int numThreads, const bool multiple, const int localRows)
+      : rank(rank), numProcs(numProcs), numThreads(numThreads), localRows(localRows), barrier(numThreads) {
+    prev = (rank - 1 + numProcs) % numProcs;
+    next = (rank + 1) % numProcs;
+
+    // a strip of one row needs both halo rows for the same row, so one thread drives both
+    splitDrivers = multiple && numThreads > 1 && localRows > 1;
+
+    buffers[0].resize(localRows, totalColumns);
+    buffers[1].resize(localRows, totalColumns);
+  }
+
+  void play(vector<uint8_t> &localCells, const int generations) {
+    buffers[0].load(localCells);
+    buffers[0].fillColumnHalo();
+    this->generations = generations;
+    nextChunk.store(0);
+
+    vector<thread> threads;
+    for (int id = 1; id < numThreads; id++) {
+      threads.push_back(thread(&HybridGame::work, this, id));
+    }
+    work(0);
+    for (thread &t : threads) t.join();
+
+    buffers[generations % 2].store(localCells);
+  }
+
+ private:
+  const int rank, numProcs, numThreads, localRows;
+  int prev, next;
+  bool splitDrivers;
+
+  PaddedBoard buffers[2];
+  int generations = 0;
+  atomic<int> nextChunk;  // the next chunk of interior rows to hand out
+  ThreadBarrier barrier;
+  mutex statisticsLock;
+
+  // update a row of the next generation, and fill its column halo
+  void updateRow(const PaddedBoard &board, PaddedBoard &nextGeneration, const int row) {
+    uint8_t *nextRow = nextGeneration.row(row);
+    nextRowPadded(board.row(row - 1), board.row(row), board.row(row + 1), nextRow, totalColumns);
+    nextRow[-1] = nextRow[totalColumns - 1];
+    nextRow[totalColumns] = nextRow[0];
+  }
+
+  // update the next chunk of interior rows - returns false if there are none left
+  bool updateChunk(const PaddedBoard &board, PaddedBoard &nextGeneration) {
+    const int interiorRows = localRows - 2;
+    const int chunk = nextChunk.fetch_add(1, memory_order_relaxed);
+    const int firstRow = 1 + chunk * chunkRows;
+    if (chunk * chunkRows >= interiorRows) return false;
+
+    const int lastRow = min(firstRow + chunkRows, localRows - 1);
+    for (int row = firstRow; row < lastRow; row++) updateRow(board, nextGeneration, row);
+    return true;
+  }
+
+  // post the exchange of one boundary row: our first row goes to the previous process (tag 0), and our last row to the next
+  // process (tag 1), and the halo rows come back the other way
+  void postExchange(PaddedBoard &board, const bool top, MPI_Request requests[2]) {
+    const int stride = board.stride;
+    if (top) {
+      MPI_Irecv(board.row(-1) - 1, stride, MPI_UINT8_T, prev, 1, MPI_COMM_WORLD, &requests[0]);
+      MPI_Isend(board.row(0) - 1, stride, MPI_UINT8_T, prev, 0, MPI_COMM_WORLD, &requests[1]);
+    } else {
+      MPI_Irecv(board.row(localRows) - 1, stride, MPI_UINT8_T, next, 0, MPI_COMM_WORLD, &requests[0]);
+      MPI_Isend(board.row(localRows - 1) - 1, stride, MPI_UINT8_T, next, 1, MPI_COMM_WORLD, &requests[1]);
+    }
+  }
+
+  // drive the exchange of the top and/or bottom halo rows: compute interior chunks while the messages are in flight, then the
+  // boundary rows that need them
+  double drive(PaddedBoard &board, PaddedBoard &nextGeneration, const bool top, const bool bottom) {
+    MPI_Request requests[4];
+    int numRequests = 0;
+    if (top) {
+      postExchange(board, true, requests + numRequests);
+      numRequests += 2;
+    }
+    if (bottom) {
+      postExchange(board, false, requests + numRequests);
+      numRequests += 2;
+    }
+
+    // keep computing interior rows until the halo is in
+    int done = 0;
+    while (!done) {
+      MPI_Testall(numRequests, requests, &done, MPI_STATUSES_IGNORE);
+      if (!done && !updateChunk(board, nextGeneration)) break;
+    }
+
+    // nothing else to compute - wait for it
+    double waitStart = MPI_Wtime();
+    if (!done) MPI_Waitall(numRequests, requests, MPI_STATUSES_IGNORE);
+    double waited = MPI_Wtime() - waitStart;
+
+    if (top) updateRow(board, nextGeneration, 0);
+    if (bottom && localRows > 1) updateRow(board, nextGeneration, localRows - 1);
+    return waited;
+  }
+
+  void work(const int id) {
+    const bool topDriver = id == 0;
+    const bool bottomDriver = splitDrivers ? id == numThreads - 1 : id == 0;
+    double waited = 0;
+
+    for (int g = 0; g < generations; g++) {
+      PaddedBoard &board = buffers[g % 2];
+      PaddedBoard &nextGeneration = buffers[(g + 1) % 2];
+
+      if (topDriver || bottomDriver) {
+        waited += drive(board, nextGeneration, topDriver, bottomDriver);
+      }
+      while (updateChunk(board, nextGeneration)) {
+      }
+
+      // every row of the next generation is done (and the sends are complete) - start the next generation
+      barrier.wait([&] { nextChunk.store(0, memory_order_relaxed); });
+    }
+
+    lock_guard<mutex> guard(statisticsLock);
+    haloWaitTime += waited;
+  }
+};
+
+// print the cell updates per second (n/a if the run was too short to time)
+void printCellUpdateRate(const char *version, const double cellUpdates, const double seconds) {
+  if (seconds > 0) {
+    printf("%s cell updates per second: %.3e\n", version, cellUpdates / seconds);
+  } else {
+    printf("%s cell updates per second: n/a\n", version);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // check the arguments before MPI starts, since they choose the thread level
+  bool multiple = false;
+  int numThreads = max(1, (int)thread::hardware_concurrency());
+  bool usageError = argc < 5;
+  for (int i = 5; i < argc && !usageError; i++) {
+    string option(argv[i]);
+    if (option == "--threads" && i + 1 < argc) {
+      numThreads = atoi(argv[++i]);
+      usageError = numThreads < 1;
+    } else if (option == "--thread-level" && i + 1 < argc) {
+      string level(argv[++i]);
+      multiple = level == "multiple";
+      usageError = level != "funneled" && level != "multiple";
+    } else {
+      usageError = true;
+    }
+  }
+
+  // initialise mpi environment, with the thread support we need
+  int required = multiple ? MPI_THREAD_MULTIPLE : MPI_THREAD_FUNNELED;
+  int provided;
+  MPI_Init_thread(&argc, &argv, required, &provided);
+
+  int rank, numProcs;
+  MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  if (usageError) {
+    if (rank == 0) {
+      printf("Usage: %s <rows> <columns> <seed> <generation> <OPTIONAL: --threads <threads per process>> <OPTIONAL: --thread-level [funneled/multiple]>\n",
+             argv[0]);
+    }
+    MPI_Finalize();
+    return 0;
+  }
+
+  if (provided < required) {
+    if (rank == 0) printf("The MPI library doesn't support the %s thread level\n", multiple ? "multiple" : "funneled");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // get the arguments
+  totalRows = atoi(argv[1]);
+  totalColumns = atoi(argv[2]);
+  int seed = atoi(argv[3]);
+  int generations = atoi(argv[4]);
+
+  if (totalRows < numProcs) {
+    if (rank == 0) printf("Please choose at least as many rows as processes\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // the strips of rows, as evenly as possible
+  vector<int> sendcounts(numProcs), displs(numProcs);
+  for (int p = 0; p < numProcs; p++) {
+    displs[p] = stripStart(p, totalRows, numProcs) * totalColumns;
+    sendcounts[p] = stripStart(p + 1, totalRows, numProcs) * totalColumns - displs[p];
+  }
+  const int localRows = sendcounts[rank] / totalColumns;
+
+  // Create and open a text file
+  ofstream outputFile;
+  if (rank == 0) outputFile.open(outputFileName);
+
+  u_int64_t runTime = 0;
+  HybridGame game(rank, numProcs, numThreads, multiple, localRows);
+
+  for (int _ = 0; _ < averageIterations; _++) {
+    // first process will generate the game board and then distribute it
+    vector<uint8_t> board;
+    if (rank == 0) {
+      board.resize(totalRows * totalColumns);
+
+      // initialise the board using the seed
+      srand(seed);
+      for (int i = 0; i < board.size(); i++) {
+        board[i] = ((double)rand() / RAND_MAX) >= 0.5 ? 1 : 0;
+      }
+
+      // print the initial board
+      outputFile << "\n";
+      printBoard(outputFile, board);
+    }
+
+    auto startTime = chrono::high_resolution_clock::now();
+
+    // distribute the rows
+    vector<uint8_t> localCells(localRows * totalColumns);
+    MPI_Scatterv(board.data(), sendcounts.data(), displs.data(), MPI_UINT8_T, localCells.data(), localCells.size(), MPI_UINT8_T, 0,
+                 MPI_COMM_WORLD);
+
+    // play the game
+    game.play(localCells, generations);
+
+    // gather the strips
+    MPI_Gatherv(localCells.data(), localCells.size(), MPI_UINT8_T, board.data(), sendcounts.data(), displs.data(), MPI_UINT8_T, 0,
+                MPI_COMM_WORLD);
+
+    auto endTime = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::microseconds>(endTime - startTime);
+    runTime += duration.count();
+
+    if (rank == 0) {
+      // print the final board
+      outputFile << "\n";
+      printBoard(outputFile, board);
+    }
+  }
+
+  // the average time a process's drivers spent waiting for its halo
+  double totalHaloWaitTime;
+  MPI_Reduce(&game.haloWaitTime, &totalHaloWaitTime, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    printf("Hybrid layout: %d processes x %d threads (%s)\n", numProcs, numThreads, multiple ? "MPI_THREAD_MULTIPLE" : "MPI_THREAD_FUNNELED");
+    printf("Hybrid average run time: %.2fms\n", (double)runTime / 1000 / averageIterations);
+    printCellUpdateRate("Hybrid", (double)totalRows * totalColumns * generations, (double)runTime / averageIterations / 1000000);
+    printf("Hybrid halo messages per generation: %d (one process per core: %d)\n", 2 * numProcs, 2 * numProcs * numThreads);
+    printf("Hybrid halo wait time per process: %.2fms\n", totalHaloWaitTime * 1000 / numProcs / averageIterations);
+    outputFile.close();
+  }
+
+  // gracefully exit the mpi environment
+  MPI_Finalize();
+  return 0;
+}
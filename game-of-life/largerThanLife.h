@@ -0,0 +1,261 @@
+#ifndef LARGER_THAN_LIFE_H
+#define LARGER_THAN_LIFE_H
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/*
+
+Larger than Life (radius-R neighbourhoods, e.g. Bosco's rule: R5,C0,M1,S34..58,B34..45,NM):
+  - the neighbourhood of a cell is the (2R + 1) x (2R + 1) square around it (with M1, the cell itself counts too)
+  - a dead cell is born if its number of live neighbours is in the birth range, and a live cell survives if it is in the
+    survival range
+  - counting the square of every cell costs O(R^2) per cell - instead, the counts come from running sums, which are O(1) per cell
+    whatever the radius:
+    * the horizontal sum of a row (the live cells within R columns of each cell) is a sliding window along the row: each step
+      adds the cell entering the window and subtracts the one leaving it (the row is first copied with R cells of wraparound on
+      each side)
+    * the counts of a row are the sum of the horizontal sums of the 2R + 1 rows around it - a running column sum, which moves
+      down a row by adding the horizontal sums of the row entering the window and subtracting the row leaving it
+    * only the horizontal sums of the 2R + 1 rows in the window are kept (a ring), so the working set is a few rows whatever
+      the size of the board
+  - the board has R halo rows above and below it (the other side of the board, or the neighbouring processes' rows), and the
+    wraparound within a row is handled by the horizontal sums
+  - the sums are 16-bit, so the radius is at most 127 ((2R + 1)^2 live cells still fit)
+
+*/
+
+const int maxLargerThanLifeRadius = 127;
+
+class LargerThanLifeRule {
+ public:
+  int radius = 1;
+  bool middle = false;  // whether a cell counts itself (M1)
+  int birthMin = 3, birthMax = 3;
+  int survivalMin = 2, survivalMax = 3;
+
+  // parse Golly's notation: "R<radius>,C<states>,M<0/1>,S<min>..<max>,B<min>..<max>,N<neighbourhood>" - the C, M and N parts are
+  // optional, but only 2 states (C0 or C2) and the Moore neighbourhood (NM) are supported
+  bool parse(const std::string &rulestring) {
+    bool haveRadius = false, haveBirth = false, haveSurvival = false;
+    size_t start = 0;
+    while (start <= rulestring.size()) {
+      size_t comma = rulestring.find(',', start);
+      if (comma == std::string::npos) comma = rulestring.size();
+      const std::string part = rulestring.substr(start, comma - start);
+      start = comma + 1;
+      if (part.empty()) return false;
+
+      const char letter = toupper(part[0]);
+      const std::string value = part.substr(1);
+      if (letter == 'R') {
+        if (!parseNumber(value, radius) || radius < 1 || radius > maxLargerThanLifeRadius) return false;
+        haveRadius = true;
+      } else if (letter == 'C') {
+        int states;
+        if (!parseNumber(value, states) || (states != 0 && states != 2)) return false;
+      } else if (letter == 'M') {
+        if (value != "0" && value != "1") return false;
+        middle = value == "1";
+      } else if (letter == 'S') {
+        if (!parseRange(value, survivalMin, survivalMax)) return false;
+        haveSurvival = true;
+      } else if (letter == 'B') {
+        if (!parseRange(value, birthMin, birthMax)) return false;
+        haveBirth = true;
+      } else if (letter == 'N') {
+        if (value != "M" && value != "m") return false;
+      } else {
+        return false;
+      }
+    }
+    if (!haveRadius || !haveBirth || !haveSurvival) return false;
+
+    // a count past the whole neighbourhood can't happen (and wouldn't fit in the 16-bit sums)
+    const int cells = (2 * radius + 1) * (2 * radius + 1);
+    birthMin = std::min(birthMin, cells + 1);
+    birthMax = std::min(birthMax, cells + 1);
+    survivalMin = std::min(survivalMin, cells + 1);
+    survivalMax = std::min(survivalMax, cells + 1);
+    return true;
+  }
+
+  std::string toString() const {
+    return "R" + std::to_string(radius) + ",C0,M" + (middle ? "1" : "0") + ",S" + std::to_string(survivalMin) + ".." +
+           std::to_string(survivalMax) + ",B" + std::to_string(birthMin) + ".." + std::to_string(birthMax) + ",NM";
+  }
+
+  // the next value of a cell with count live cells in its neighbourhood (including itself with M1)
+  bool nextValue(const bool alive, const int count) const {
+    return alive ? count >= survivalMin && count <= survivalMax : count >= birthMin && count <= birthMax;
+  }
+
+ private:
+  static bool parseNumber(const std::string &digits, int &number) {
+    if (digits.empty() || digits.size() > 6 || digits.find_first_not_of("0123456789") != std::string::npos) return false;
+    number = atoi(digits.c_str());
+    return true;
+  }
+
+  // "<min>..<max>", or a single count
+  static bool parseRange(const std::string &range, int &low, int &high) {
+    const size_t dots = range.find("..");
+    if (dots == std::string::npos) {
+      if (!parseNumber(range, low)) return false;
+      high = low;
+      return true;
+    }
+    return parseNumber(range.substr(0, dots), low) && parseNumber(range.substr(dots + 2), high) && low <= high;
+  }
+};
+
+// is a rule string in Larger than Life notation (instead of B/S)
+inline bool isLargerThanLifeRule(const std::string &rulestring) {
+  return rulestring.size() > 1 && toupper(rulestring[0]) == 'R' && isdigit(rulestring[1]);
+}
+
+// a byte per cell, with radius halo rows above and below the board
+class RadiusBoard {
+ public:
+  int rows = 0;
+  int columns = 0;
+  int radius = 0;
+  std::vector<uint8_t> cells;
+
+  void resize(const int numRows, const int numColumns, const int numRadius) {
+    rows = numRows;
+    columns = numColumns;
+    radius = numRadius;
+    cells.assign((size_t)(rows + 2 * radius) * columns, 0);
+  }
+
+  // the first cell of a row (rows -radius to -1 and rows to rows + radius - 1 are the halo rows)
+  uint8_t *row(const int r) {
+    return cells.data() + (size_t)(r + radius) * columns;
+  }
+
+  const uint8_t *row(const int r) const {
+    return cells.data() + (size_t)(r + radius) * columns;
+  }
+
+  // wraparound: copy the other side of the board into the halo rows
+  void fillRowHalo() {
+    memcpy(row(-radius), row(rows - radius), (size_t)radius * columns);
+    memcpy(row(rows), row(0), (size_t)radius * columns);
+  }
+
+  bool sameCells(const RadiusBoard &other) const {
+    return memcmp(row(0), other.row(0), (size_t)rows * columns) == 0;
+  }
+
+  // copy in a board of 0/1 cells, stored row by row
+  template <typename Cells>
+  void load(const Cells &board) {
+    for (int r = 0; r < rows; r++) {
+      uint8_t *cellsOfRow = row(r);
+      for (int c = 0; c < columns; c++) {
+        cellsOfRow[c] = board[(size_t)r * columns + c] ? 1 : 0;
+      }
+    }
+  }
+
+  // copy out into a board of 0/1 cells, stored row by row
+  template <typename Cells>
+  void store(Cells &board) const {
+    for (int r = 0; r < rows; r++) {
+      const uint8_t *cellsOfRow = row(r);
+      for (int c = 0; c < columns; c++) {
+        board[(size_t)r * columns + c] = cellsOfRow[c];
+      }
+    }
+  }
+};
+
+class LargerThanLife {
+ public:
+  LargerThanLifeRule rule;
+
+  // play a generation: every row of board (whose halo rows must be filled) into the same row of next
+  void step(const RadiusBoard &board, RadiusBoard &next) {
+    const int radius = rule.radius;
+    const int columns = board.columns;
+    const int window = 2 * radius + 1;
+    extended.resize(columns + 2 * radius);
+    sums.resize((size_t)window * columns);
+    counts.assign(columns, 0);
+
+    // the window of the first row: the horizontal sums of rows -radius to radius
+    for (int r = -radius; r <= radius; r++) {
+      uint16_t *rowSums = windowRow(r);
+      horizontalSums(board.row(r), columns, rowSums);
+      for (int c = 0; c < columns; c++) counts[c] += rowSums[c];
+    }
+
+    // 16-bit ranges (unsigned, so a count below the minimum wraps around to a large number)
+    const uint16_t birthMin = rule.birthMin, birthSpan = rule.birthMax - rule.birthMin;
+    const uint16_t survivalMin = rule.survivalMin, survivalSpan = rule.survivalMax - rule.survivalMin;
+    const uint16_t self = rule.middle ? 0 : 1;
+
+    for (int r = 0; r < board.rows; r++) {
+      const uint8_t *current = board.row(r);
+      uint8_t *nextRow = next.row(r);
+      // branch-free, so the compiler can vectorise it
+      const uint16_t *rowCounts = counts.data();
+      for (int c = 0; c < columns; c++) {
+        const uint16_t alive = current[c];
+        const uint16_t count = rowCounts[c] - self * alive;
+        const uint16_t survives = (uint16_t)(count - survivalMin) <= survivalSpan;
+        const uint16_t born = (uint16_t)(count - birthMin) <= birthSpan;
+        nextRow[c] = (alive & survives) | (~alive & born);
+      }
+
+      // move the window down a row: row r - radius leaves it, and row r + radius + 1 enters it (in the same slot of the ring)
+      if (r + 1 < board.rows) {
+        uint16_t *rowSums = windowRow(r - radius);
+        entering.resize(columns);
+        horizontalSums(board.row(r + radius + 1), columns, entering.data());
+        uint16_t *rowCounts = counts.data();
+        const uint16_t *enteringSums = entering.data();
+        for (int c = 0; c < columns; c++) {
+          rowCounts[c] += enteringSums[c] - rowSums[c];
+          rowSums[c] = enteringSums[c];
+        }
+      }
+    }
+  }
+
+ private:
+  std::vector<uint8_t> extended;  // a row, with radius cells of wraparound on each side
+  std::vector<uint16_t> sums;     // the horizontal sums of the rows in the window (a ring of 2 * radius + 1 rows)
+  std::vector<uint16_t> entering;
+  std::vector<uint16_t> counts;   // the sum of the window, for every column
+
+  uint16_t *windowRow(const int r) {
+    const int window = 2 * rule.radius + 1;
+    return sums.data() + (size_t)(((r % window) + window) % window) * (sums.size() / window);
+  }
+
+  // the live cells within radius columns of each cell of a row (wrapping around the row)
+  void horizontalSums(const uint8_t *cells, const int columns, uint16_t *rowSums) {
+    const int radius = rule.radius;
+    memcpy(extended.data(), cells + columns - radius, radius);
+    memcpy(extended.data() + radius, cells, columns);
+    memcpy(extended.data() + radius + columns, cells, radius);
+
+    uint16_t sum = 0;
+    for (int c = 0; c < 2 * radius + 1; c++) sum += extended[c];
+    rowSums[0] = sum;
+    for (int c = 1; c < columns; c++) {
+      sum += extended[c + 2 * radius] - extended[c - 1];
+      rowSums[c] = sum;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef LIFE_RULE_H
+#define LIFE_RULE_H
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include <string>
+
+/*
+
+Life-like rules in B/S notation (e.g. B3/S23 is Conway's Game of Life):
+  - a dead cell is born if its number of live neighbours is one of the B digits
+  - a live cell survives if its number of live neighbours is one of the S digits
+  - a rule is a mask: bit n is birth with n neighbours, and bit 9 + n is survival with n neighbours, so the next value of any
+    cell is a single shift: (mask >> (alive * 9 + neighbours)) & 1
+  - the masks of the common rules are compile-time constants (constexpr), so an engine can be a template on its rule, and the
+    rule then compiles away; any other rule is a runtime mask
+
+*/
+
+// the bits of the neighbour counts in a string of digits ("23" -> bits 2 and 3)
+constexpr uint16_t countsMask(const char *digits) {
+  return *digits == 0 ? 0 : (uint16_t)((1 << (*digits - '0')) | countsMask(digits + 1));
+}
+
+constexpr uint32_t ruleMask(const uint16_t birth, const uint16_t survival) {
+  return birth | (uint32_t)survival << 9;
+}
+
+// the next value of a cell under a rule mask
+constexpr bool ruleNextValue(const uint32_t mask, const bool alive, const int neighbours) {
+  return (mask >> ((alive ? 9 : 0) + neighbours)) & 1;
+}
+
+// the common rules
+const uint32_t conwayRule = ruleMask(countsMask("3"), countsMask("23"));              // B3/S23
+const uint32_t highLifeRule = ruleMask(countsMask("36"), countsMask("23"));           // B36/S23
+const uint32_t dayAndNightRule = ruleMask(countsMask("3678"), countsMask("34678"));   // B3678/S34678
+const uint32_t seedsRule = ruleMask(countsMask("2"), countsMask(""));                 // B2/S
+
+// a template argument that means "the rule is only known at runtime"
+const uint32_t runtimeRule = 0xFFFFFFFF;
+
+class LifeRule {
+ public:
+  uint16_t birth = countsMask("3");
+  uint16_t survival = countsMask("23");
+
+  uint32_t mask() const {
+    return ruleMask(birth, survival);
+  }
+
+  bool isConway() const {
+    return mask() == conwayRule;
+  }
+
+  // parse "B<digits>/S<digits>" (in either order, any case), or the older "<survival digits>/<birth digits>"
+  bool parse(const std::string &rulestring) {
+    size_t slash = rulestring.find('/');
+    if (slash == std::string::npos) return false;
+
+    std::string parts[2] = {rulestring.substr(0, slash), rulestring.substr(slash + 1)};
+    uint16_t masks[2];
+    char letters[2];
+    for (int i = 0; i < 2; i++) {
+      letters[i] = parts[i].empty() || isdigit(parts[i][0]) ? 0 : toupper(parts[i][0]);
+      masks[i] = 0;
+      for (size_t j = letters[i] ? 1 : 0; j < parts[i].size(); j++) {
+        if (parts[i][j] < '0' || parts[i][j] > '8') return false;
+        masks[i] |= 1 << (parts[i][j] - '0');
+      }
+    }
+
+    if (letters[0] == 0 && letters[1] == 0) {
+      // S/B
+      survival = masks[0];
+      birth = masks[1];
+    } else if (letters[0] == 'B' && letters[1] == 'S') {
+      birth = masks[0];
+      survival = masks[1];
+    } else if (letters[0] == 'S' && letters[1] == 'B') {
+      survival = masks[0];
+      birth = masks[1];
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  std::string toString() const {
+    std::string rulestring = "B";
+    for (int n = 0; n <= 8; n++) {
+      if ((birth >> n) & 1) rulestring += (char)('0' + n);
+    }
+    rulestring += "/S";
+    for (int n = 0; n <= 8; n++) {
+      if ((survival >> n) & 1) rulestring += (char)('0' + n);
+    }
+    return rulestring;
+  }
+};
+
+#endif
@@ -0,0 +1,257 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "bitBoard.h"
+#include "boardFile.h"
+#include "lifeRule.h"
+
+/*
+
+Out-of-core boards (bigger than memory):
+  - the board lives in a binary board file (see boardFile.h - 1 bit per cell), memory-mapped, and each generation streams it
+    into a second board file - the two files swap roles every generation (double buffering), so no board is ever in memory
+  - the rows are processed in strips of a few MiB: a rolling window of three strips (the strip being updated, and the strips
+    above and below it) is copied into aligned 64-bit words and updated with the bit-packed kernel (see bitBoard.h) - the rows of
+    a board file are already bits in the same order, so a row is a memcpy in and a memcpy out
+  - ahead of the compute front, the strip after the next one is prefetched (madvise(MADV_WILLNEED)); behind it, each strip
+    that was written is handed to the kernel to write back (sync_file_range), and the pages of both files that are finished with
+    are dropped (madvise(MADV_DONTNEED), posix_fadvise(POSIX_FADV_DONTNEED)), so the board doesn't fill the page cache either
+  - the memory used is the window and a few rows, whatever the size of the board: the limit is the size of the disk, and the
+    speed is its streaming bandwidth (or the kernel's, while the files are cached)
+  - a mapping can be some of the rows of a board file, so each MPI process maps (and streams) its own rows of the same files
+
+*/
+
+const size_t outOfCoreStripBytes = 4 * 1024 * 1024;
+
+// create a board file of rows x columns (all dead, and sparse until it's written) - false if it can't be
+inline bool createBoardFile(const std::string &fileName, const int64_t rows, const int64_t columns) {
+  const int file = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (file < 0) return false;
+
+  uint8_t header[boardFileHeaderSize];
+  boardFileHeader(rows, columns, header);
+  const bool created = pwrite(file, header, boardFileHeaderSize, 0) == boardFileHeaderSize &&
+                       ftruncate(file, boardFileHeaderSize + rows * (int64_t)boardFileRowBytes(columns)) == 0;
+  close(file);
+  return created;
+}
+
+// some of the rows of a board file, memory-mapped (rows are numbered as on the whole board)
+class MappedBoard {
+ public:
+  int64_t rows = 0;       // of the whole board
+  int64_t columns = 0;
+  int64_t firstRow = 0;   // the rows that are mapped
+  int64_t numRows = 0;
+  size_t rowBytes = 0;
+
+  ~MappedBoard() {
+    unmap();
+  }
+
+  // map rows [first, first + count) of a board file of boardRows x boardColumns - false if it can't be
+  bool map(const std::string &fileName, const int64_t boardRows, const int64_t boardColumns, const int64_t first, const int64_t count) {
+    unmap();
+    rows = boardRows;
+    columns = boardColumns;
+    firstRow = first;
+    numRows = count;
+    rowBytes = boardFileRowBytes(columns);
+
+    file = open(fileName.c_str(), O_RDWR);
+    if (file < 0) return false;
+
+    // the mapping starts at a page boundary
+    const int64_t start = boardFileHeaderSize + firstRow * (int64_t)rowBytes;
+    mappingOffset = start / pageSize() * pageSize();
+    mappingBytes = start - mappingOffset + numRows * rowBytes;
+    void *mapped = mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, mappingOffset);
+    if (mapped == MAP_FAILED) {
+      close(file);
+      file = -1;
+      return false;
+    }
+    mapping = (uint8_t *)mapped;
+    data = mapping + (start - mappingOffset);
+
+    // the rows are streamed in order
+    madvise(mapping, mappingBytes, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  // write the rows back, and unmap them
+  void unmap() {
+    if (mapping == nullptr) return;
+    msync(mapping, mappingBytes, MS_SYNC);
+    munmap(mapping, mappingBytes);
+    close(file);
+    mapping = nullptr;
+    file = -1;
+  }
+
+  uint8_t *row(const int64_t r) {
+    return data + (r - firstRow) * rowBytes;
+  }
+
+  // ask for rows [first, first + count) to be read ahead (the pages they touch)
+  void prefetch(const int64_t first, const int64_t count) {
+    size_t from, to;
+    pages(first, count, false, from, to);
+    if (to > from) madvise(mapping + from, to - from, MADV_WILLNEED);
+  }
+
+  // start writing rows [first, first + count) back to the file, without waiting for it
+  void writeBehind(const int64_t first, const int64_t count) {
+#ifdef SYNC_FILE_RANGE_WRITE
+    size_t from, to;
+    pages(first, count, false, from, to);
+    if (to > from) sync_file_range(file, mappingOffset + from, to - from, SYNC_FILE_RANGE_WRITE);
+#endif
+  }
+
+  // finish writing rows [first, first + count) back, and drop the pages that only they touch from memory
+  void release(const int64_t first, const int64_t count) {
+    size_t from, to;
+    pages(first, count, true, from, to);
+    if (to <= from) return;
+#ifdef SYNC_FILE_RANGE_WRITE
+    sync_file_range(file, mappingOffset + from, to - from, SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+#endif
+    madvise(mapping + from, to - from, MADV_DONTNEED);
+    posix_fadvise(file, mappingOffset + from, to - from, POSIX_FADV_DONTNEED);
+  }
+
+ private:
+  int file = -1;
+  uint8_t *mapping = nullptr;
+  size_t mappingBytes = 0;
+  off_t mappingOffset = 0;
+  uint8_t *data = nullptr;  // the first mapped row
+
+  static size_t pageSize() {
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+  }
+
+  // the pages (offsets in the mapping) of rows [first, first + count) - only the pages entirely within them if inner, so a page
+  // shared with a neighbouring row is never dropped
+  void pages(const int64_t first, const int64_t count, const bool inner, size_t &from, size_t &to) const {
+    const size_t start = (data - mapping) + (first - firstRow) * rowBytes;
+    const size_t end = start + count * rowBytes;
+    const size_t page = pageSize();
+    from = inner ? (start + page - 1) / page * page : start / page * page;
+    to = inner ? end / page * page : std::min(mappingBytes, (end + page - 1) / page * page);
+  }
+};
+
+class OutOfCoreStrips {
+ public:
+  LifeRule rule;
+  int stripRows = 0;
+  int64_t columns = 0;
+  int wordsPerRow = 0;
+
+  // choose the strip size for numRows (or more) of numColumns
+  void resize(const int64_t numRows, const int64_t numColumns, const size_t stripBytes = outOfCoreStripBytes) {
+    columns = numColumns;
+    wordsPerRow = (columns + 63) / 64;
+    stripRows = std::max<int64_t>(1, std::min<int64_t>(numRows, stripBytes / (wordsPerRow * 8)));
+    window.assign((size_t)3 * stripRows * wordsPerRow, 0);
+    aboveWords.assign(wordsPerRow, 0);
+    belowWords.assign(wordsPerRow, 0);
+    nextWords.assign(wordsPerRow, 0);
+  }
+
+  // fill the mapped rows with the counter-based initial board of a seed (see boardFile.h), a strip at a time
+  // returns its live cells
+  uint64_t initialise(MappedBoard &board, const uint64_t seed) {
+    uint64_t population = 0;
+    for (int64_t first = board.firstRow; first < board.firstRow + board.numRows; first += stripRows) {
+      const int64_t height = std::min<int64_t>(stripRows, board.firstRow + board.numRows - first);
+      for (int64_t r = first; r < first + height; r++) {
+        std::fill(nextWords.begin(), nextWords.end(), 0);
+        for (int64_t c = 0; c < columns; c++) {
+          if (counterCell(seed, (uint64_t)r * columns + c)) nextWords[c >> 6] |= (uint64_t)1 << (c & 63);
+        }
+        memcpy(board.row(r), nextWords.data(), board.rowBytes);
+        for (int w = 0; w < wordsPerRow; w++) population += __builtin_popcountll(nextWords[w]);
+      }
+      board.writeBehind(first, height);
+      if (first > board.firstRow) board.release(first - stripRows, stripRows);
+    }
+    return population;
+  }
+
+  // play a generation of the rows of from into the same rows of to - above and below are the (packed) rows just above the first
+  // row and just below the last (the other side of the board, or the neighbouring processes' rows)
+  // returns the live cells of the new generation
+  uint64_t play(MappedBoard &from, MappedBoard &to, const uint8_t *above, const uint8_t *below) {
+    const int64_t first = from.firstRow;
+    const int64_t strips = (from.numRows + stripRows - 1) / stripRows;
+    memcpy(aboveWords.data(), above, from.rowBytes);
+    memcpy(belowWords.data(), below, from.rowBytes);
+
+    uint64_t population = 0;
+    loadStrip(from, 0);
+    if (strips > 1) from.prefetch(first + stripRows, stripHeight(from, 1));
+
+    for (int64_t s = 0; s < strips; s++) {
+      // the window moves down a strip: the next strip replaces the one two above this one, and the strip after it is read ahead
+      if (s + 1 < strips) loadStrip(from, s + 1);
+      if (s + 2 < strips) from.prefetch(first + (s + 2) * stripRows, stripHeight(from, s + 2));
+
+      const int height = stripHeight(from, s);
+      for (int r = 0; r < height; r++) {
+        const uint64_t *rowAbove = r > 0 ? windowRow(s, r - 1) : s > 0 ? windowRow(s - 1, stripRows - 1) : aboveWords.data();
+        const uint64_t *rowBelow = r + 1 < height ? windowRow(s, r + 1) : s + 1 < strips ? windowRow(s + 1, 0) : belowWords.data();
+        nextRowBits(rowAbove, windowRow(s, r), rowBelow, nextWords.data(), wordsPerRow, columns, rule);
+        memcpy(to.row(first + s * stripRows + r), nextWords.data(), to.rowBytes);
+        for (int w = 0; w < wordsPerRow; w++) population += __builtin_popcountll(nextWords[w]);
+      }
+
+      // behind the compute front: this strip starts going to the disk, and the one before it is finished with
+      to.writeBehind(first + s * stripRows, height);
+      if (s > 0) to.release(first + (s - 1) * stripRows, stripRows);
+    }
+    to.release(first + (strips - 1) * stripRows, stripHeight(from, strips - 1));
+    return population;
+  }
+
+ private:
+  std::vector<uint64_t> window;  // three strips of rows, as words (strip s is in slot s % 3)
+  std::vector<uint64_t> aboveWords, belowWords, nextWords;
+
+  uint64_t *windowRow(const int64_t strip, const int r) {
+    return window.data() + ((size_t)(strip % 3) * stripRows + r) * wordsPerRow;
+  }
+
+  int stripHeight(const MappedBoard &board, const int64_t strip) const {
+    return std::min<int64_t>(stripRows, board.numRows - strip * stripRows);
+  }
+
+  // copy a strip of rows into its slot of the window (the bits past the last column of a row are zero in the file), and let
+  // its pages go
+  void loadStrip(MappedBoard &board, const int64_t strip) {
+    const int height = stripHeight(board, strip);
+    const int64_t first = board.firstRow + strip * stripRows;
+    for (int r = 0; r < height; r++) {
+      uint64_t *words = windowRow(strip, r);
+      words[wordsPerRow - 1] = 0;
+      memcpy(words, board.row(first + r), board.rowBytes);
+    }
+    board.release(first, height);
+  }
+};
+
+#endif
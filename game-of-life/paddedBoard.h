@@ -0,0 +1,246 @@
+#ifndef PADDED_BOARD_H
+#define PADDED_BOARD_H
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "lifeRule.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PADDED_BOARD_X86
+#endif
+
+/*
+
+Ghost-cell padded board:
+  - one byte per cell, with a one cell halo (ghost cells) on every side: (rows + 2) x (columns + 2) bytes
+  - the halo is filled once per generation (a copy of the other side of the board for the wraparound, or the
+    neighbouring process's row in the MPI version), so the update itself never needs modular arithmetic or branches
+  - the update of a row sums the 8 neighbour rows (shifted by -1, 0, +1 columns) into byte lanes, 32 cells at a time (AVX2),
+    and applies B3/S23 with compares: alive next generation = (sum == 3) | (alive & (sum == 2))
+  - the AVX2 kernel is chosen at runtime (when the CPU supports it); otherwise a branch-free scalar kernel is used
+  - other rules (see lifeRule.h) look their next values up instead: the AVX2 kernel looks up the birth and survival values of
+    32 sums at once with byte shuffles (the sums are 0 - 8, so a 16 entry table holds each), and picks one by the current cell
+
+*/
+
+class PaddedBoard {
+ public:
+  int rows = 0;
+  int columns = 0;
+  int stride = 0;
+  std::vector<uint8_t> cells;
+
+  void resize(const int numRows, const int numColumns) {
+    rows = numRows;
+    columns = numColumns;
+    stride = numColumns + 2;
+    cells.assign((size_t)(rows + 2) * stride, 0);
+  }
+
+  // the first interior cell of a row (row -1 and row "rows" are the halo rows; column -1 and column "columns" are the halo columns)
+  uint8_t *row(const int r) {
+    return cells.data() + (size_t)(r + 1) * stride + 1;
+  }
+
+  const uint8_t *row(const int r) const {
+    return cells.data() + (size_t)(r + 1) * stride + 1;
+  }
+
+  // wraparound within each row (including the halo rows, which fills the corners)
+  void fillColumnHalo() {
+    for (int r = -1; r <= rows; r++) {
+      uint8_t *cellsOfRow = row(r);
+      cellsOfRow[-1] = cellsOfRow[columns - 1];
+      cellsOfRow[columns] = cellsOfRow[0];
+    }
+  }
+
+  // wraparound between the first and last rows (only the interior columns - fill the column halo afterwards)
+  void fillRowHalo() {
+    memcpy(row(-1), row(rows - 1), columns);
+    memcpy(row(rows), row(0), columns);
+  }
+
+  // wraparound for part of the board only: copy the cells of rows [firstRow, lastRow) x columns [firstColumn, lastColumn)
+  // that are on an edge of the board into the halo on the other side (so regions can fill the halo independently)
+  void fillHaloFrom(const int firstRow, const int lastRow, const int firstColumn, const int lastColumn) {
+    const int width = lastColumn - firstColumn;
+    if (firstRow == 0) memcpy(row(rows) + firstColumn, row(0) + firstColumn, width);
+    if (lastRow == rows) memcpy(row(-1) + firstColumn, row(rows - 1) + firstColumn, width);
+
+    for (int r = firstRow; r < lastRow; r++) {
+      if (firstColumn == 0) row(r)[columns] = row(r)[0];
+      if (lastColumn == columns) row(r)[-1] = row(r)[columns - 1];
+    }
+
+    // each corner of the halo is a copy of the opposite corner of the board
+    if (firstRow == 0 && firstColumn == 0) row(rows)[columns] = row(0)[0];
+    if (firstRow == 0 && lastColumn == columns) row(rows)[-1] = row(0)[columns - 1];
+    if (lastRow == rows && firstColumn == 0) row(-1)[columns] = row(rows - 1)[0];
+    if (lastRow == rows && lastColumn == columns) row(-1)[-1] = row(rows - 1)[columns - 1];
+  }
+
+  // do two boards have the same cells (the halos aren't compared)
+  bool sameCells(const PaddedBoard &other) const {
+    for (int r = 0; r < rows; r++) {
+      if (memcmp(row(r), other.row(r), columns) != 0) return false;
+    }
+    return true;
+  }
+
+  // copy in a board of 0/1 cells, stored row by row
+  template <typename Cells>
+  void load(const Cells &board) {
+    for (int r = 0; r < rows; r++) {
+      uint8_t *cellsOfRow = row(r);
+      for (int c = 0; c < columns; c++) {
+        cellsOfRow[c] = board[(size_t)r * columns + c] ? 1 : 0;
+      }
+    }
+  }
+
+  // copy out into a board of 0/1 cells, stored row by row
+  template <typename Cells>
+  void store(Cells &board) const {
+    for (int r = 0; r < rows; r++) {
+      const uint8_t *cellsOfRow = row(r);
+      for (int c = 0; c < columns; c++) {
+        board[(size_t)r * columns + c] = cellsOfRow[c];
+      }
+    }
+  }
+};
+
+// update the cells [from, columns) of a row - the neighbours at column -1 and "columns" are halo cells
+inline void nextRowPaddedScalar(const uint8_t *above, const uint8_t *current, const uint8_t *below, uint8_t *next, const int from,
+                                const int columns) {
+  for (int c = from; c < columns; c++) {
+    int sum = above[c - 1] + above[c] + above[c + 1] + current[c - 1] + current[c + 1] + below[c - 1] + below[c] + below[c + 1];
+    next[c] = (sum == 3) | (current[c] & (sum == 2));
+  }
+}
+
+#ifdef PADDED_BOARD_X86
+// 32 cells at a time, then the scalar kernel for the remainder
+__attribute__((target("avx2"))) inline void nextRowPaddedAVX2(const uint8_t *above, const uint8_t *current, const uint8_t *below, uint8_t *next,
+                                                               const int columns) {
+  const __m256i ones = _mm256_set1_epi8(1);
+  const __m256i twos = _mm256_set1_epi8(2);
+  const __m256i threes = _mm256_set1_epi8(3);
+
+  int c = 0;
+  for (; c + 32 <= columns; c += 32) {
+    // the three rows, each at column offsets -1, 0, +1 (the centre cell itself is left out)
+    __m256i sum = _mm256_loadu_si256((const __m256i *)(above + c - 1));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(above + c)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(above + c + 1)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(current + c - 1)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(current + c + 1)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(below + c - 1)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(below + c)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(below + c + 1)));
+
+    __m256i alive = _mm256_loadu_si256((const __m256i *)(current + c));
+
+    // (sum == 3) | (alive & (sum == 2)), as 0/1 bytes
+    __m256i birthOrSurvive = _mm256_cmpeq_epi8(sum, threes);
+    __m256i survive = _mm256_and_si256(_mm256_cmpeq_epi8(sum, twos), _mm256_cmpeq_epi8(alive, ones));
+    __m256i result = _mm256_and_si256(_mm256_or_si256(birthOrSurvive, survive), ones);
+
+    _mm256_storeu_si256((__m256i *)(next + c), result);
+  }
+
+  nextRowPaddedScalar(above, current, below, next, c, columns);
+}
+#endif
+
+// update the cells [from, columns) of a row under any rule (given as a rule mask)
+inline void nextRowPaddedRuleScalar(const uint8_t *above, const uint8_t *current, const uint8_t *below, uint8_t *next, const int from,
+                                    const int columns, const uint32_t rule) {
+  for (int c = from; c < columns; c++) {
+    int sum = above[c - 1] + above[c] + above[c + 1] + current[c - 1] + current[c + 1] + below[c - 1] + below[c] + below[c + 1];
+    next[c] = (rule >> (current[c] * 9 + sum)) & 1;
+  }
+}
+
+#ifdef PADDED_BOARD_X86
+// the next values for each sum (0 - 8) under a mask of neighbour counts, as a byte table for _mm256_shuffle_epi8 (in both lanes)
+__attribute__((target("avx2"))) inline __m256i ruleTable(const uint16_t counts) {
+  alignas(32) uint8_t table[32] = {0};
+  for (int n = 0; n <= 8; n++) {
+    table[n] = table[16 + n] = (counts >> n) & 1;
+  }
+  return _mm256_load_si256((const __m256i *)table);
+}
+
+// 32 cells at a time under any rule, then the scalar kernel for the remainder
+__attribute__((target("avx2"))) inline void nextRowPaddedRuleAVX2(const uint8_t *above, const uint8_t *current, const uint8_t *below, uint8_t *next,
+                                                                   const int columns, const uint32_t rule) {
+  const __m256i ones = _mm256_set1_epi8(1);
+  const __m256i birthTable = ruleTable(rule & 0x1FF);
+  const __m256i survivalTable = ruleTable(rule >> 9);
+
+  int c = 0;
+  for (; c + 32 <= columns; c += 32) {
+    __m256i sum = _mm256_loadu_si256((const __m256i *)(above + c - 1));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(above + c)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(above + c + 1)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(current + c - 1)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(current + c + 1)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(below + c - 1)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(below + c)));
+    sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *)(below + c + 1)));
+
+    // look up both outcomes, and keep the survival one for the live cells
+    __m256i alive = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(current + c)), ones);
+    __m256i born = _mm256_shuffle_epi8(birthTable, sum);
+    __m256i survive = _mm256_shuffle_epi8(survivalTable, sum);
+    _mm256_storeu_si256((__m256i *)(next + c), _mm256_blendv_epi8(born, survive, alive));
+  }
+
+  nextRowPaddedRuleScalar(above, current, below, next, c, columns, rule);
+}
+#endif
+
+// use the AVX2 kernel if the CPU supports it
+inline bool paddedBoardUsesAVX2() {
+#ifdef PADDED_BOARD_X86
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+#else
+  return false;
+#endif
+}
+
+// update a row of the padded board (the halo cells around it must already be filled)
+inline void nextRowPadded(const uint8_t *above, const uint8_t *current, const uint8_t *below, uint8_t *next, const int columns) {
+#ifdef PADDED_BOARD_X86
+  if (paddedBoardUsesAVX2()) {
+    nextRowPaddedAVX2(above, current, below, next, columns);
+    return;
+  }
+#endif
+  nextRowPaddedScalar(above, current, below, next, 0, columns);
+}
+
+// update a row of the padded board under any rule (B3/S23 uses its own kernel)
+inline void nextRowPadded(const uint8_t *above, const uint8_t *current, const uint8_t *below, uint8_t *next, const int columns,
+                          const LifeRule &rule) {
+  if (rule.isConway()) {
+    nextRowPadded(above, current, below, next, columns);
+    return;
+  }
+#ifdef PADDED_BOARD_X86
+  if (paddedBoardUsesAVX2()) {
+    nextRowPaddedRuleAVX2(above, current, below, next, columns, rule.mask());
+    return;
+  }
+#endif
+  nextRowPaddedRuleScalar(above, current, below, next, 0, columns, rule.mask());
+}
+
+#endif
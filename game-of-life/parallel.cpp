@@ -1,30 +1,152 @@
 #include <mpi.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <fstream>
+#include <memory>
+#include <numeric>
 #include <string>
 #include <vector>
 
+#include "activeTiles.h"
+#include "bitBoard.h"
+#include "boardFile.h"
+#include "cycleDetector.h"
+#include "ensemble.h"
+#include "largerThanLife.h"
+#include "lifeRule.h"
+#include "outOfCore.h"
+#include "paddedBoard.h"
+#include "patternFile.h"
+#include "snapshotStream.h"
+
 using namespace std;
 
 /*
 
 ARCHITECTURE:
-- divide the rows amongst the processes, in order of rank. The last process will have any extras
+- divide the rows amongst the processes, in order of rank. The first (rows % processes) processes get an extra row
 - have a logical "ring" interconnect network
 - each process will receive the prev proc last row, and send the last row of curr proc
 
+2D DECOMPOSITION (--decomposition 2d):
+- the processes form a periodic 2d grid (MPI_Cart_create), with its shape chosen by MPI_Dims_create
+- each process gets a block of rows and columns, stored as a padded byte board
+- each process exchanges its edges with its 8 neighbours (N, S, W, E and the 4 diagonals for the corners), straight into the padding
+  * the columns aren't contiguous, so they are sent with a vector datatype (one cell every stride bytes)
+- the halo of a block is its perimeter, so the communication per process shrinks as the number of processes grows
+
+ONE-SIDED HALOS (--halo rma/shared, padded engine):
+- each process exposes the two buffers of its padded board in RMA windows, and the neighbours MPI_Put their boundary rows
+  straight into its halo rows - there is no matching receive, and the only synchronisation is an exposure/access epoch
+  (MPI_Win_post/start/complete/wait) with the two neighbours, which the interior rows are updated inside of
+- with --halo shared, the buffers are allocated in a shared-memory window of the node (MPI_Win_allocate_shared), and a neighbour
+  on the same node isn't sent anything: its boundary row is read in place when our first or last row is updated
+  * each process publishes the number of generations it has finished (a counter in its segment of the shared window), and a
+    process waits until its neighbours have finished the last generation before it starts the next one - their rows are then
+    ready, and they are done reading the buffer it is about to overwrite
+  * neighbours on other nodes still put their rows into the halo rows
+
+REBALANCING (--rebalance <generations>, padded and tiled engines):
+- an even split of the rows isn't an even split of the work: the tiled engine skips the settled parts of the board, so a strip
+  with a lot of activity costs far more than a quiet one (and processes can run at different speeds)
+- each process measures the compute time of each of its rows (the tiled engine times each row of tiles), and every interval
+  the processes agree on new strip boundaries: a prefix sum (MPI_Exscan) of the costs tells each process where its rows are in
+  the total cost, so it can place the boundaries that fall within them - boundary k goes where k / processes of the cost is before it
+- the rows that cross a boundary are sent point to point between the two processes on either side of it - a boundary can't
+  move past its neighbouring boundaries, so every process keeps some of its rows, and a bigger move takes a few intervals
+
+LARGER THAN LIFE (--engine ltl, rows decomposition):
+- a radius R rule needs R rows of halo above and below each process's rows - each generation, a process sends its first R rows
+  to the previous process and its last R rows to the next one (so every process needs at least R rows)
+- the counts of the whole strip then come from running sums over the rows and their halo (see largerThanLife.h)
+
+ENSEMBLE (--ensemble <boards>):
+- many small boards, one per seed, are played whole by single processes instead of being split between them (see ensemble.h)
+- the work queue is a counter on rank 0, in an RMA window: a process takes the next seed with MPI_Fetch_and_op, so no process
+  is dedicated to handing out the boards, and a process that finishes its boards sooner just takes more
+- the summaries of the boards are gathered by rank 0 at the end
+
+OUT OF CORE (--out-of-core <directory>, rows decomposition):
+- the board is never in memory: it lives in a board file (and the next generation in a second one) which every process maps its
+  own rows of, and streams a strip at a time (see outOfCore.h) - the directory must be visible to every process (e.g. a
+  parallel file system)
+- each generation, a process sends its first packed row to the previous process and its last to the next one (the rows are
+  already packed in the file, so they are sent straight from the mapping)
+
+SNAPSHOTS (--snapshots <generations>, rows decomposition):
+- each process streams its own rows to its own file in the background (see snapshotStream.h) - there is no communication, and
+  each record holds the first row and the number of rows, so the strips can be put back together after rebalancing
+
 */
 
 const string outputFileName = "parallel-output.txt";
+const string binaryOutputFileName = "parallel-output.bin";
+const string snapshotFilePrefix = "parallel-snapshots-";  // then the rank, and ".gol"
+const string ensembleFileName = "parallel-ensemble.txt";
 const int averageIterations = 5;
 
 int totalRows;
 int totalColumns;
 int localRows;
+uint64_t firstCellIndex;  // the index on the whole board of this process's first cell
+
+// the rule to play (B3/S23 unless --rule is given)
+LifeRule rule;
+
+// the Larger than Life rule to play, for the ltl engine (B3/S23 as a radius 1 rule unless --rule is given in Larger than Life notation)
+LargerThanLifeRule ltlRule;
+bool largerThanLife = false;
+
+// the rule, as it is written in pattern files and printed
+string ruleString() {
+  return largerThanLife ? ltlRule.toString() : rule.toString();
+}
+
+// the time this process spent waiting for halo rows (over every run)
+double haloWaitTime = 0;
+
+// the number of halo messages this process sent (with deep halos, over every run)
+uint64_t haloMessages = 0;
+
+// stop playing whole periods once the board repeats (see cycleDetector.h)
+bool detectCycles = false;
+
+// the cycle found by the last run (period 0 if none was - every process finds the same one)
+int cyclePeriod = 0;
+int cycleStart = 0;
+int cycleConfirmedAt = 0;
+int cycleSkipped = 0;
+
+// the tiled engine's statistics (this process, over every run)
+uint64_t tilesEvaluated = 0;
+uint64_t tilesConsidered = 0;
+
+// move the strip boundaries to balance the measured cost every rebalanceInterval generations (0: never) - unless the slowest
+// process is within rebalanceTolerance of the average already
+int rebalanceInterval = 0;
+const double rebalanceTolerance = 1.05;
+
+// the rebalancing statistics: this process's compute time per generation before the first rebalance (the even split) and
+// after the last one (of the last run), and the number of rebalances and the rows this process sent (over every run)
+double timeBeforeRebalancing = 0;
+double timeAfterRebalancing = 0;
+uint64_t rebalances = 0;
+uint64_t rowsMigrated = 0;
+
+// stream every snapshotInterval-th generation of this process's rows to its own snapshot file, in the background
+// (see snapshotStream.h) - 0 is off
+int snapshotInterval = 0;
+SnapshotStream *snapshots = nullptr;
+
+// should generation be streamed to the snapshot file
+bool snapshotDue(const int generation) {
+  return snapshots != nullptr && generation % snapshotInterval == 0;
+}
 
 // convert a 2d coordinate to a 1d value
 int convertToIndex(const int row, const int column) {
@@ -41,7 +163,61 @@ void printBoard(ofstream &file, const vector<int> &board) {
   }
 }
 
-// apply the Game-of-Life rules
+// place a pattern file on the board, with its top left corner at (atRow, atColumn) - the pattern wraps around the edges
+bool placePattern(const string &fileName, const int atRow, const int atColumn, vector<int> &board) {
+  ifstream file(fileName);
+  if (!file) {
+    printf("Couldn't open the pattern file: %s\n", fileName.c_str());
+    return false;
+  }
+
+  string error;
+  auto setCell = [&](const int64_t row, const int64_t column) {
+    board[convertToIndex((row + atRow) % totalRows, (column + atColumn) % totalColumns)] = 1;
+  };
+  if (!readPattern(file, setCell, error)) {
+    printf("Couldn't read the pattern file %s: %s\n", fileName.c_str(), error.c_str());
+    return false;
+  }
+  return true;
+}
+
+// save the board as a pattern file (plaintext for .cells/.txt, otherwise RLE)
+void savePattern(const string &fileName, const vector<int> &board) {
+  ofstream file(fileName);
+  auto getCell = [&](const int64_t row, const int64_t column) -> bool { return board[convertToIndex(row, column)]; };
+  if (isPlaintextFileName(fileName)) {
+    writePlaintext(file, totalRows, totalColumns, getCell);
+  } else {
+    writeRLE(file, totalRows, totalColumns, getCell, ruleString());
+  }
+}
+
+// the hash of the whole board, from the hash of this process's rows (a single reduction)
+uint64_t boardHash(const uint64_t localHash) {
+  uint64_t hash;
+  MPI_Allreduce(&localHash, &hash, 1, MPI_UINT64_T, MPI_BXOR, MPI_COMM_WORLD);
+  return hash;
+}
+
+// are the boards of every process the same as the ones they are compared with
+bool sameEverywhere(const bool same) {
+  int localSame = same, allSame;
+  MPI_Allreduce(&localSame, &allSame, 1, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+  return allSame;
+}
+
+// note the cycle found by a run
+template <typename Board>
+void recordCycle(const CycleDetector<Board> &detector) {
+  cyclePeriod = detector.period;
+  cycleStart = detector.cycleStart;
+  cycleConfirmedAt = detector.confirmedAt;
+  cycleSkipped = detector.skipped;
+}
+
+// apply the rules - Rule is a rule mask (see lifeRule.h), or runtimeRule for a rule that is only known at runtime
+template <uint32_t Rule>
 bool cellNextValue(vector<int> &board, vector<int> &prevRow, vector<int> &nextRow, const int row, const int col) {
   // track the number of live neighbours
   int numAlive = 0;
@@ -70,25 +246,9 @@ bool cellNextValue(vector<int> &board, vector<int> &prevRow, vector<int> &nextRo
     }
   }
 
-  if (board[convertToIndex(row, col)]) {
-    // current cell is ALIVE
-
-    if (numAlive == 2 || numAlive == 3) {
-      // A live cell remains alive if there are 2 or 3 live neighbours;
-      return true;
-    } else {
-      // A live cell dies if the number of live neighbours is less than 2 (loneliness) or greater than 3 (over-crowding)
-      return false;
-    }
-  } else {
-    // current cell is DEAD
-    if (numAlive == 3) {
-      // A dead cell will birth a new cell if there are exactly 3 live neighbours.
-      return true;
-    } else {
-      return false;
-    }
-  }
+  // B3/S23: a live cell remains alive if there are 2 or 3 live neighbours, and a dead cell will birth a new cell if there are
+  // exactly 3 live neighbours - other rules change those counts
+  return ruleNextValue(Rule == runtimeRule ? rule.mask() : Rule, board[convertToIndex(row, col)], numAlive);
 }
 
 void communicateWithPrevious(vector<int> &localBoard, vector<int> &prevRow, const int prev, const int generation) {
@@ -107,7 +267,45 @@ void communicateWithNext(vector<int> &localBoard, vector<int> &nextRow, const in
                MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 }
 
-void playGame(const int rank, const int numProcs, const int generations, vector<int> &localBoard) {
+// update the rows [firstRow, lastRow) of the local board
+template <uint32_t Rule>
+void updateRowsRule(vector<int> &localBoard, vector<int> &prevRow, vector<int> &nextRow, vector<int> &nextGeneration, const int firstRow,
+                    const int lastRow) {
+  for (int row = firstRow; row < lastRow; row++) {
+    for (int col = 0; col < totalColumns; col++) {
+      // can now perform the update
+      nextGeneration[convertToIndex(row, col)] = cellNextValue<Rule>(localBoard, prevRow, nextRow, row, col) ? 1 : 0;
+    }
+  }
+}
+
+// update the rows [firstRow, lastRow) of the local board - the common rules use their compiled versions
+void updateRows(vector<int> &localBoard, vector<int> &prevRow, vector<int> &nextRow, vector<int> &nextGeneration, const int firstRow,
+                const int lastRow) {
+  switch (rule.mask()) {
+    case conwayRule:
+      updateRowsRule<conwayRule>(localBoard, prevRow, nextRow, nextGeneration, firstRow, lastRow);
+      break;
+    case highLifeRule:
+      updateRowsRule<highLifeRule>(localBoard, prevRow, nextRow, nextGeneration, firstRow, lastRow);
+      break;
+    case dayAndNightRule:
+      updateRowsRule<dayAndNightRule>(localBoard, prevRow, nextRow, nextGeneration, firstRow, lastRow);
+      break;
+    case seedsRule:
+      updateRowsRule<seedsRule>(localBoard, prevRow, nextRow, nextGeneration, firstRow, lastRow);
+      break;
+    default:
+      updateRowsRule<runtimeRule>(localBoard, prevRow, nextRow, nextGeneration, firstRow, lastRow);
+  }
+}
+
+// haloMode:
+//  - blocking: exchange the halo rows with MPI_Sendrecv, then update every row
+//  - nonblocking: post MPI_Isend/MPI_Irecv, update the interior rows (which don't need the halo) while the messages are in
+//    flight, then wait and update the first and last rows
+//  - persistent: the same as nonblocking, but the requests are created once and restarted every generation
+void playGame(const int rank, const int numProcs, const int generations, vector<int> &localBoard, const string &haloMode) {
   // determine the communication partners
   int prev = (rank - 1 + numProcs) % numProcs;
   int next = (rank + 1 + numProcs) % numProcs;
@@ -118,130 +316,1667 @@ void playGame(const int rank, const int numProcs, const int generations, vector<
   nextRow.resize(totalColumns);
   nextGeneration.resize(localRows * totalColumns);
 
+  // persistent requests are bound to their buffers, and the board alternates between two buffers - so there is a set for each
+  // (requests[parity]: receive prevRow, receive nextRow, send the first row, send the last row)
+  MPI_Request requests[2][4];
+  if (haloMode == "persistent") {
+    vector<int> *buffers[2] = {&localBoard, &nextGeneration};
+    for (int parity = 0; parity < 2; parity++) {
+      int *cells = buffers[parity]->data();
+      MPI_Recv_init(prevRow.data(), totalColumns, MPI_INT, prev, 1, MPI_COMM_WORLD, &requests[parity][0]);
+      MPI_Recv_init(nextRow.data(), totalColumns, MPI_INT, next, 0, MPI_COMM_WORLD, &requests[parity][1]);
+      MPI_Send_init(cells, totalColumns, MPI_INT, prev, 0, MPI_COMM_WORLD, &requests[parity][2]);
+      MPI_Send_init(cells + (localRows - 1) * totalColumns, totalColumns, MPI_INT, next, 1, MPI_COMM_WORLD, &requests[parity][3]);
+    }
+  }
+
+  // the rows that need the halo
+  const int lastInterior = max(1, localRows - 1);
+
+  // the hash of our rows (relative to the initial board, see boardFile.h) is updated from the cells that change
+  CycleDetector<vector<int>> detector(generations, [](const vector<int> &a, const vector<int> &b) { return sameEverywhere(a == b); });
+  uint64_t hash = 0;
+
+  // the buffer the board is in (the persistent requests are bound to it) - skipped generations don't swap the buffers
+  int parity = 0;
+
   // play the game
   for (int i = 0; i < generations; i++) {
-    // avoid deadlock
-    if (rank % 2 == 0) {
-      communicateWithPrevious(localBoard, prevRow, prev, i);
-      communicateWithNext(localBoard, nextRow, next, i);
+    if (haloMode == "blocking") {
+      double waitStart = MPI_Wtime();
+
+      // avoid deadlock
+      if (rank % 2 == 0) {
+        communicateWithPrevious(localBoard, prevRow, prev, i);
+        communicateWithNext(localBoard, nextRow, next, i);
+      } else {
+        communicateWithNext(localBoard, nextRow, next, i);
+        communicateWithPrevious(localBoard, prevRow, prev, i);
+      }
+      haloWaitTime += MPI_Wtime() - waitStart;
+
+      updateRows(localBoard, prevRow, nextRow, nextGeneration, 0, localRows);
     } else {
-      communicateWithNext(localBoard, nextRow, next, i);
-      communicateWithPrevious(localBoard, prevRow, prev, i);
+      MPI_Request *generationRequests = requests[parity];
+      if (haloMode == "persistent") {
+        MPI_Startall(4, generationRequests);
+      } else {
+        // the first row goes to the previous process (tag 0), the last row to the next process (tag 1)
+        MPI_Irecv(prevRow.data(), totalColumns, MPI_INT, prev, 1, MPI_COMM_WORLD, &generationRequests[0]);
+        MPI_Irecv(nextRow.data(), totalColumns, MPI_INT, next, 0, MPI_COMM_WORLD, &generationRequests[1]);
+        MPI_Isend(localBoard.data(), totalColumns, MPI_INT, prev, 0, MPI_COMM_WORLD, &generationRequests[2]);
+        MPI_Isend(localBoard.data() + (localRows - 1) * totalColumns, totalColumns, MPI_INT, next, 1, MPI_COMM_WORLD, &generationRequests[3]);
+      }
+
+      // the interior rows only need our own rows
+      updateRows(localBoard, prevRow, nextRow, nextGeneration, 1, lastInterior);
+
+      double waitStart = MPI_Wtime();
+      MPI_Waitall(4, generationRequests, MPI_STATUSES_IGNORE);
+      haloWaitTime += MPI_Wtime() - waitStart;
+
+      // now the first and last rows
+      updateRows(localBoard, prevRow, nextRow, nextGeneration, 0, 1);
+      updateRows(localBoard, prevRow, nextRow, nextGeneration, lastInterior, localRows);
+    }
+
+    // have determined the next generation of the board - make it active
+    if (detectCycles) hash ^= hashCellChanges(localBoard, nextGeneration, localBoard.size(), firstCellIndex);
+    localBoard.swap(nextGeneration);
+    parity ^= 1;
+    if (detectCycles) i += detector.observe(i + 1, boardHash(hash), localBoard);
+    if (snapshotDue(i + 1)) snapshots->recordCells(i + 1, firstCellIndex / totalColumns, localRows, localBoard);
+  }
+
+  if (detectCycles) recordCycle(detector);
+
+  if (haloMode == "persistent") {
+    for (int parity = 0; parity < 2; parity++) {
+      for (int r = 0; r < 4; r++) MPI_Request_free(&requests[parity][r]);
     }
+  }
+}
+
+// play the game on bit-packed rows - the halo rows are also packed (64 cells per word)
+void playGameBitPacked(const int rank, const int numProcs, const int generations, BitBoard &localBoard) {
+  // determine the communication partners
+  int prev = (rank - 1 + numProcs) % numProcs;
+  int next = (rank + 1 + numProcs) % numProcs;
+  const int wordsPerRow = localBoard.wordsPerRow;
+
+  // prepare the structures to play the game
+  vector<uint64_t> prevRow(wordsPerRow), nextRow(wordsPerRow);
+  BitBoard nextGeneration;
+  nextGeneration.resize(localRows, totalColumns);
+
+  CycleDetector<vector<uint64_t>> detector(generations, [](const vector<uint64_t> &a, const vector<uint64_t> &b) { return sameEverywhere(a == b); });
+  uint64_t hash = 0;
+
+  // play the game
+  for (int i = 0; i < generations; i++) {
+    // send the first row to the previous process, and the last row to the next process
+    // (a single process is its own neighbour in both directions)
+    MPI_Sendrecv(localBoard.row(0), wordsPerRow, MPI_UINT64_T, prev, 2 * i,                  // send
+                 nextRow.data(), wordsPerRow, MPI_UINT64_T, next, 2 * i,                     // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(localBoard.row(localRows - 1), wordsPerRow, MPI_UINT64_T, next, 2 * i + 1,  // send
+                 prevRow.data(), wordsPerRow, MPI_UINT64_T, prev, 2 * i + 1,                 // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
 
-    // for each cell on the local board
+    // update each row, one word (64 cells) at a time
     for (int row = 0; row < localRows; row++) {
-      for (int col = 0; col < totalColumns; col++) {
-        // can now perform the update
-        nextGeneration[convertToIndex(row, col)] = cellNextValue(localBoard, prevRow, nextRow, row, col) ? 1 : 0;
-      }
+      const uint64_t *above = row == 0 ? prevRow.data() : localBoard.row(row - 1);
+      const uint64_t *below = row == localRows - 1 ? nextRow.data() : localBoard.row(row + 1);
+      nextRowBits(above, localBoard.row(row), below, nextGeneration.row(row), wordsPerRow, totalColumns, rule);
+      if (detectCycles) hash ^= hashBitChanges(localBoard.row(row), nextGeneration.row(row), wordsPerRow, firstCellIndex + (uint64_t)row * totalColumns);
     }
 
     // have determined the next generation of the board - make it active
-    localBoard.swap(nextGeneration);
+    localBoard.words.swap(nextGeneration.words);
+    if (detectCycles) i += detector.observe(i + 1, boardHash(hash), localBoard.words);
+    if (snapshotDue(i + 1)) snapshots->recordBits(i + 1, firstCellIndex / totalColumns, localRows, localBoard);
   }
+
+  if (detectCycles) recordCycle(detector);
 }
 
-int main(int argc, char *argv[]) {
-  // initialise mpi environment
-  MPI_Init(&argc, &argv);
+// is it time to rebalance, after generation i
+bool rebalanceDue(const int i, const int generations) {
+  return rebalanceInterval > 0 && (i + 1) % rebalanceInterval == 0 && i + 1 < generations;
+}
 
-  int rank, numProcs;
+// the cost of each row, from the time spent on each row of tiles (the rows of a tile row share its time)
+void tileRowCosts(const ActiveTiles &tiles, vector<double> &rowCosts) {
+  for (int row = 0; row < localRows; row++) {
+    const int tr = row / tiles.tileHeight;
+    rowCosts[row] = tiles.tileRowTimes[tr] / (min(localRows, (tr + 1) * tiles.tileHeight) - tr * tiles.tileHeight);
+  }
+}
 
-  // get the number of processes and this process's rank
-  MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
-  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+// move the strip boundaries so that each process has about the same share of the cost of the last interval (see REBALANCING),
+// and send the rows that cross them - returns whether any boundary moved (on every process)
+bool rebalanceRows(const int rank, const int numProcs, const int generation, PaddedBoard &localBoard, vector<double> &rowCosts) {
+  const double localCost = accumulate(rowCosts.begin(), rowCosts.end(), 0.0);
+  if (generation == rebalanceInterval) timeBeforeRebalancing = localCost / rebalanceInterval;
+  rebalances++;
 
-  // check we have the arguments we need
-  if (argc < 5) {
-    if (rank == 0) printf("Usage: %s <rows> <columns> <seed> <generation>\n", argv[0]);
-    MPI_Finalize();
-    return 0;
+  // the current boundaries: process p has the rows [starts[p], starts[p + 1])
+  vector<int> numRows(numProcs), starts(numProcs + 1, 0);
+  MPI_Allgather(&localRows, 1, MPI_INT, numRows.data(), 1, MPI_INT, MPI_COMM_WORLD);
+  for (int p = 0; p < numProcs; p++) starts[p + 1] = starts[p] + numRows[p];
+
+  // the cost of the processes before this one, and of every process
+  double costBefore = 0, totalCost, slowestCost;
+  MPI_Exscan(&localCost, &costBefore, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  if (rank == 0) costBefore = 0;
+  MPI_Allreduce(&localCost, &totalCost, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  MPI_Allreduce(&localCost, &slowestCost, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+  // moving rows isn't free (the tiled engine evaluates every tile again), so a strip that is close enough stays
+  if (slowestCost * numProcs <= rebalanceTolerance * totalCost) {
+    rowCosts.assign(localRows, 0);
+    return false;
   }
 
-  // Create and open a text file
-  ofstream outputFile;
-  if (rank == 0) {
-    outputFile.open(outputFileName);
+  // place the boundaries whose share of the cost falls within our rows (a row goes before the boundary if more than half of its
+  // cost does) - the other processes place the rest
+  vector<int> placed(numProcs + 1, -1), newStarts(numProcs + 1);
+  double cost = costBefore;
+  int row = 0;
+  for (int k = 1; k < numProcs; k++) {
+    const double target = totalCost * k / numProcs;
+    if (target < costBefore || target >= costBefore + localCost) continue;
+    while (row < localRows && cost + rowCosts[row] / 2 < target) cost += rowCosts[row++];
+    placed[k] = starts[rank] + row;
   }
+  MPI_Allreduce(placed.data(), newStarts.data(), numProcs + 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
 
-  // get the arguments
-  totalRows = atoi(argv[1]);
-  totalColumns = atoi(argv[2]);
-  int seed = atoi(argv[3]);
-  int generations = atoi(argv[4]);
+  // a boundary stays between its neighbouring boundaries, so rows only move between neighbouring processes, and every process
+  // keeps at least one row
+  newStarts[0] = 0;
+  newStarts[numProcs] = totalRows;
+  for (int k = 1; k < numProcs; k++) {
+    if (newStarts[k] < 0) newStarts[k] = starts[k];
+    newStarts[k] = max(newStarts[k], max(starts[k - 1], newStarts[k - 1] + 1));
+    newStarts[k] = min(newStarts[k], starts[k + 1] - 1);
+  }
 
-  u_int64_t runTime = 0;
+  if (newStarts == starts) {
+    rowCosts.assign(localRows, 0);
+    return false;
+  }
 
-  for (int _ = 0; _ < averageIterations; _++) {
-    // first process will generate the game board and then distribute it
-    vector<int> board, localBoard;
-    if (rank == 0) {
-      board.resize(totalRows * totalColumns);
+  const int oldStart = starts[rank], oldEnd = starts[rank + 1];
+  const int newStart = newStarts[rank], newEnd = newStarts[rank + 1];
+  const int stride = localBoard.stride;
 
-      // initialise the board using the seed
-      srand(seed);
-      for (int i = 0; i < board.size(); i++) {
-        int value = ((double)rand() / RAND_MAX) >= 0.5 ? 1 : 0;
-        board[i] = value;
+  // the rows we keep (padded rows are contiguous, so a run of rows is one copy, or one message)
+  PaddedBoard newBoard;
+  newBoard.resize(newEnd - newStart, totalColumns);
+  const int keepStart = max(oldStart, newStart), keepEnd = min(oldEnd, newEnd);
+  memcpy(newBoard.row(keepStart - newStart) - 1, localBoard.row(keepStart - oldStart) - 1, (size_t)(keepEnd - keepStart) * stride);
+
+  // the first and last boundaries never move, so the neighbours are never across the wraparound
+  // (rows moving down the board have tag 0, and rows moving up have tag 1)
+  MPI_Request requests[4];
+  int numRequests = 0;
+  if (newStart < oldStart) {
+    MPI_Irecv(newBoard.row(0) - 1, (oldStart - newStart) * stride, MPI_UINT8_T, rank - 1, 0, MPI_COMM_WORLD, &requests[numRequests++]);
+  }
+  if (newEnd > oldEnd) {
+    MPI_Irecv(newBoard.row(oldEnd - newStart) - 1, (newEnd - oldEnd) * stride, MPI_UINT8_T, rank + 1, 1, MPI_COMM_WORLD, &requests[numRequests++]);
+  }
+  if (newEnd < oldEnd) {
+    MPI_Isend(localBoard.row(newEnd - oldStart) - 1, (oldEnd - newEnd) * stride, MPI_UINT8_T, rank + 1, 0, MPI_COMM_WORLD, &requests[numRequests++]);
+    rowsMigrated += oldEnd - newEnd;
+  }
+  if (newStart > oldStart) {
+    MPI_Isend(localBoard.row(0) - 1, (newStart - oldStart) * stride, MPI_UINT8_T, rank - 1, 1, MPI_COMM_WORLD, &requests[numRequests++]);
+    rowsMigrated += newStart - oldStart;
+  }
+  MPI_Waitall(numRequests, requests, MPI_STATUSES_IGNORE);
+
+  swap(localBoard, newBoard);
+  localRows = newEnd - newStart;
+  firstCellIndex = (uint64_t)newStart * totalColumns;
+  rowCosts.assign(localRows, 0);
+  return true;
+}
+
+// note this process's compute time per generation since the last rebalance (at the end of a run)
+void finishRebalancing(const vector<double> &rowCosts, const int generations) {
+  if (generations == 0) return;
+  const int lastRebalance = (generations - 1) / rebalanceInterval * rebalanceInterval;
+  timeAfterRebalancing = accumulate(rowCosts.begin(), rowCosts.end(), 0.0) / (generations - lastRebalance);
+  if (lastRebalance == 0) timeBeforeRebalancing = timeAfterRebalancing;
+}
+
+// the cells of each process, and where they start on the whole board (rebalancing moves the boundaries during a run)
+void gatherCounts(const int numProcs, int sendcounts[], int displs[]) {
+  const int localCount = localRows * totalColumns;
+  MPI_Allgather(&localCount, 1, MPI_INT, sendcounts, 1, MPI_INT, MPI_COMM_WORLD);
+  displs[0] = 0;
+  for (int i = 1; i < numProcs; i++) displs[i] = displs[i - 1] + sendcounts[i - 1];
+}
+
+// play the game on a padded byte board - the halo rows are received straight into the padding, so the update never branches
+void playGamePadded(const int rank, const int numProcs, const int generations, PaddedBoard &localBoard) {
+  // determine the communication partners
+  int prev = (rank - 1 + numProcs) % numProcs;
+  int next = (rank + 1 + numProcs) % numProcs;
+
+  // whole padded rows are exchanged, so the corners of the halo come with them
+  const int stride = localBoard.stride;
+
+  PaddedBoard nextGeneration;
+  nextGeneration.resize(localRows, totalColumns);
+
+  CycleDetector<PaddedBoard> detector(generations, [](const PaddedBoard &a, const PaddedBoard &b) { return sameEverywhere(a.sameCells(b)); });
+  uint64_t hash = 0;
+
+  // the compute time of each row since the last rebalance (every row of the strip costs the same)
+  vector<double> rowCosts(localRows);
+
+  // play the game
+  for (int i = 0; i < generations; i++) {
+    // the wraparound within each row is local
+    localBoard.fillColumnHalo();
+
+    // send the first row to the previous process, and the last row to the next process
+    double waitStart = MPI_Wtime();
+    MPI_Sendrecv(localBoard.row(0) - 1, stride, MPI_UINT8_T, prev, 2 * i,                  // send
+                 localBoard.row(localRows) - 1, stride, MPI_UINT8_T, next, 2 * i,          // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(localBoard.row(localRows - 1) - 1, stride, MPI_UINT8_T, next, 2 * i + 1,  // send
+                 localBoard.row(-1) - 1, stride, MPI_UINT8_T, prev, 2 * i + 1,             // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    haloWaitTime += MPI_Wtime() - waitStart;
+
+    double computeStart = MPI_Wtime();
+    for (int row = 0; row < localRows; row++) {
+      nextRowPadded(localBoard.row(row - 1), localBoard.row(row), localBoard.row(row + 1), nextGeneration.row(row), totalColumns, rule);
+      if (detectCycles) hash ^= hashByteChanges(localBoard.row(row), nextGeneration.row(row), totalColumns, firstCellIndex + (uint64_t)row * totalColumns);
+    }
+    if (rebalanceInterval > 0) {
+      const double rowCost = (MPI_Wtime() - computeStart) / localRows;
+      for (double &cost : rowCosts) cost += rowCost;
+    }
+
+    // have determined the next generation of the board - make it active
+    localBoard.cells.swap(nextGeneration.cells);
+    if (detectCycles) i += detector.observe(i + 1, boardHash(hash), localBoard);
+    if (snapshotDue(i + 1)) snapshots->recordPadded(i + 1, firstCellIndex / totalColumns, localRows, localBoard);
+
+    if (rebalanceDue(i, generations) && rebalanceRows(rank, numProcs, i + 1, localBoard, rowCosts)) {
+      nextGeneration.resize(localRows, totalColumns);
+    }
+  }
+
+  if (detectCycles) recordCycle(detector);
+  if (rebalanceInterval > 0) finishRebalancing(rowCosts, generations);
+}
+
+// the first interior cell of row r of a padded buffer (row -1 and row "rows" are the halo rows, see paddedBoard.h)
+uint8_t *paddedRow(uint8_t *buffer, const int stride, const int r) {
+  return buffer + (size_t)(r + 1) * stride + 1;
+}
+
+// wait until a process on this node has finished the given number of generations (its counter is in the shared window)
+void waitForGenerations(const uint64_t *counter, const uint64_t generations, MPI_Win sharedWindow) {
+  while (__atomic_load_n(counter, __ATOMIC_ACQUIRE) < generations) {
+    MPI_Win_sync(sharedWindow);
+    sched_yield();
+  }
+  MPI_Win_sync(sharedWindow);
+}
+
+// play the game on a padded byte board with one-sided halo exchanges (see ONE-SIDED HALOS): the boundary rows are put into the
+// neighbours' halo rows, or (sharedMemory) read in place from a neighbour on the same node
+void playGameOneSided(const int rank, const int numProcs, const int generations, PaddedBoard &localBoard, const bool sharedMemory) {
+  // determine the communication partners
+  int prev = (rank - 1 + numProcs) % numProcs;
+  int next = (rank + 1 + numProcs) % numProcs;
+  const int stride = localBoard.stride;
+
+  // the neighbours' rows (where their boundary rows are)
+  int prevRows, nextRows;
+  MPI_Sendrecv(&localRows, 1, MPI_INT, next, 0, &prevRows, 1, MPI_INT, prev, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(&localRows, 1, MPI_INT, prev, 1, &nextRows, 1, MPI_INT, next, 1, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+  // our segment of the node's shared window: the generation counter (on its own cache line), then the two buffers of the board
+  const MPI_Aint counterBytes = 64;
+  const MPI_Aint bufferBytes = (MPI_Aint)(localRows + 2) * stride;
+  MPI_Comm node;
+  MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &node);
+  uint8_t *segment;
+  MPI_Win sharedWindow;
+  MPI_Win_allocate_shared(counterBytes + 2 * bufferBytes, 1, MPI_INFO_NULL, node, &segment, &sharedWindow);
+
+  uint64_t *counter = (uint64_t *)segment;
+  uint8_t *buffers[2] = {segment + counterBytes, segment + counterBytes + bufferBytes};
+  *counter = 0;
+  localBoard.fillColumnHalo();
+  memcpy(buffers[0], localBoard.cells.data(), bufferBytes);
+  memset(buffers[1], 0, bufferBytes);
+
+  // the neighbours on this node (when sharedMemory) are read in place, from their segments of the shared window
+  MPI_Group worldGroup, nodeGroup;
+  MPI_Comm_group(MPI_COMM_WORLD, &worldGroup);
+  MPI_Comm_group(node, &nodeGroup);
+  int neighbours[2] = {prev, next}, nodeRanks[2];
+  MPI_Group_translate_ranks(worldGroup, 2, neighbours, nodeGroup, nodeRanks);
+  const bool sharedPrev = sharedMemory && nodeRanks[0] != MPI_UNDEFINED;
+  const bool sharedNext = sharedMemory && nodeRanks[1] != MPI_UNDEFINED;
+
+  uint64_t *prevCounter = nullptr, *nextCounter = nullptr;
+  uint8_t *prevBuffers[2] = {nullptr, nullptr}, *nextBuffers[2] = {nullptr, nullptr};
+  MPI_Aint size;
+  int unit;
+  uint8_t *base;
+  if (sharedPrev) {
+    MPI_Win_shared_query(sharedWindow, nodeRanks[0], &size, &unit, &base);
+    prevCounter = (uint64_t *)base;
+    prevBuffers[0] = base + counterBytes;
+    prevBuffers[1] = base + counterBytes + (MPI_Aint)(prevRows + 2) * stride;
+  }
+  if (sharedNext) {
+    MPI_Win_shared_query(sharedWindow, nodeRanks[1], &size, &unit, &base);
+    nextCounter = (uint64_t *)base;
+    nextBuffers[0] = base + counterBytes;
+    nextBuffers[1] = base + counterBytes + (MPI_Aint)(nextRows + 2) * stride;
+  }
+
+  // the other neighbours put their rows into our halo rows: through the shared window when every process is on this node (its
+  // ranks are the same as MPI_COMM_WORLD's then), otherwise through a window for each buffer, since the board alternates between them
+  int nodeSize;
+  MPI_Comm_size(node, &nodeSize);
+  const bool oneNode = nodeSize == numProcs;
+  MPI_Win windows[2] = {sharedWindow, sharedWindow};
+  if (!oneNode) {
+    for (int parity = 0; parity < 2; parity++) {
+      MPI_Win_create(buffers[parity], bufferBytes, 1, MPI_INFO_NULL, MPI_COMM_WORLD, &windows[parity]);
+    }
+  }
+
+  // where a neighbour's buffer starts in the window
+  auto bufferStart = [&](const int parity, const int rows) -> MPI_Aint {
+    return oneNode ? counterBytes + parity * (MPI_Aint)(rows + 2) * stride : 0;
+  };
+
+  int remote[2], numRemote = 0;
+  if (!sharedPrev) remote[numRemote++] = prev;
+  if (!sharedNext && next != prev) remote[numRemote++] = next;
+  MPI_Group remoteGroup;
+  MPI_Group_incl(worldGroup, numRemote, remote, &remoteGroup);
+
+  // (the counters are only read in shared mode - the shared window is free for the puts otherwise)
+  if (sharedMemory) MPI_Win_lock_all(MPI_MODE_NOCHECK, sharedWindow);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  // the buffer the board is in
+  int parity = 0;
+
+  // play the game
+  for (int i = 0; i < generations; i++) {
+    uint8_t *current = buffers[parity], *nextGeneration = buffers[parity ^ 1];
+
+    // the neighbours on this node must have finished the last generation
+    double waitStart = MPI_Wtime();
+    if (sharedPrev) waitForGenerations(prevCounter, i, sharedWindow);
+    if (sharedNext) waitForGenerations(nextCounter, i, sharedWindow);
+    haloWaitTime += MPI_Wtime() - waitStart;
+
+    // put our first row into the previous process's bottom halo row, and our last row into the next process's top halo row
+    if (numRemote > 0) {
+      MPI_Win_post(remoteGroup, 0, windows[parity]);
+      MPI_Win_start(remoteGroup, 0, windows[parity]);
+      if (!sharedPrev) {
+        MPI_Put(paddedRow(current, stride, 0) - 1, stride, MPI_UINT8_T, prev, bufferStart(parity, prevRows) + (MPI_Aint)(prevRows + 1) * stride, stride,
+                MPI_UINT8_T, windows[parity]);
+      }
+      if (!sharedNext) {
+        MPI_Put(paddedRow(current, stride, localRows - 1) - 1, stride, MPI_UINT8_T, next, bufferStart(parity, nextRows), stride, MPI_UINT8_T,
+                windows[parity]);
       }
+    }
 
-      // print the initial board
-      outputFile << "\n";
-      printBoard(outputFile, board);
+    // the interior rows only need our own rows
+    for (int row = 1; row < localRows - 1; row++) {
+      nextRowPadded(paddedRow(current, stride, row - 1), paddedRow(current, stride, row), paddedRow(current, stride, row + 1),
+                    paddedRow(nextGeneration, stride, row), totalColumns, rule);
     }
 
-    auto startTime = chrono::high_resolution_clock::now();
+    if (numRemote > 0) {
+      waitStart = MPI_Wtime();
+      MPI_Win_complete(windows[parity]);
+      MPI_Win_wait(windows[parity]);
+      haloWaitTime += MPI_Wtime() - waitStart;
+    }
 
-    // determine the number of rows per process
-    localRows = round((double)totalRows / numProcs);
-    int lastRows = totalRows - localRows * (numProcs - 1);
+    // now the first and last rows, with the rows that were put into our halo, or the neighbours' rows in place
+    const uint8_t *above = sharedPrev ? paddedRow(prevBuffers[parity], stride, prevRows - 1) : paddedRow(current, stride, -1);
+    const uint8_t *below = sharedNext ? paddedRow(nextBuffers[parity], stride, 0) : paddedRow(current, stride, localRows);
+    nextRowPadded(above, paddedRow(current, stride, 0), localRows > 1 ? paddedRow(current, stride, 1) : below, paddedRow(nextGeneration, stride, 0),
+                  totalColumns, rule);
+    if (localRows > 1) {
+      nextRowPadded(paddedRow(current, stride, localRows - 2), paddedRow(current, stride, localRows - 1), below,
+                    paddedRow(nextGeneration, stride, localRows - 1), totalColumns, rule);
+    }
 
-    // distribute the rows
-    // determine the number of elements to send to each process, and the offset in the vector
-    int sendcounts[numProcs];
-    int displs[numProcs];
-    sendcounts[0] = localRows * totalColumns;
-    displs[0] = 0;
-    for (int i = 1; i < numProcs; i++) {
-      sendcounts[i] = localRows * totalColumns;
-      displs[i] = displs[i - 1] + totalColumns * localRows;
+    // the wraparound within each row, for the neighbours (the rows they are put or read are whole padded rows)
+    for (int row = 0; row < localRows; row++) {
+      uint8_t *cells = paddedRow(nextGeneration, stride, row);
+      cells[-1] = cells[totalColumns - 1];
+      cells[totalColumns] = cells[0];
     }
-    sendcounts[numProcs - 1] = lastRows * totalColumns;
 
-    // the last process picks up any straggler rows
-    if (rank == numProcs - 1) {
-      localRows = lastRows;
+    // have determined the next generation of the board - make it active, and tell the neighbours on this node
+    parity ^= 1;
+    if (sharedMemory) {
+      MPI_Win_sync(sharedWindow);
+      __atomic_store_n(counter, i + 1, __ATOMIC_RELEASE);
     }
+    if (snapshotDue(i + 1)) {
+      snapshots->record(i + 1, firstCellIndex / totalColumns, localRows,
+                        [&](const int r, uint8_t *bits) { packByteRow(paddedRow(buffers[parity], stride, r), totalColumns, bits); });
+    }
+  }
 
-    // resize the local boards to hold the appropriate number of cells
-    localBoard.resize(localRows * totalColumns);
+  memcpy(localBoard.cells.data(), buffers[parity], bufferBytes);
 
-    // distribute the rows
-    MPI_Scatterv(board.data(), sendcounts, displs, MPI_INT, localBoard.data(), localRows * totalColumns, MPI_INT, 0, MPI_COMM_WORLD);
+  // the neighbours may still be reading our rows
+  if (sharedMemory) MPI_Win_unlock_all(sharedWindow);
+  MPI_Barrier(MPI_COMM_WORLD);
 
-    // play the game
-    playGame(rank, numProcs, generations, localBoard);
+  if (!oneNode) {
+    for (int parity = 0; parity < 2; parity++) MPI_Win_free(&windows[parity]);
+  }
+  MPI_Win_free(&sharedWindow);
+  MPI_Group_free(&remoteGroup);
+  MPI_Group_free(&nodeGroup);
+  MPI_Group_free(&worldGroup);
+  MPI_Comm_free(&node);
+}
 
-    // gather the localBoards
-    MPI_Gatherv(localBoard.data(), localRows * totalColumns, MPI_INT, board.data(), sendcounts, displs, MPI_INT, 0, MPI_COMM_WORLD);
+// exchange depth boundary rows of a deep board with the neighbours: our first own rows fill the previous process's bottom halo,
+// and our last own rows fill the next process's top halo (a single process is its own neighbour in both directions)
+void exchangeDeepHalo(PaddedBoard &deepBoard, const int depth, const int prev, const int next, const int tag) {
+  const int ownRows = deepBoard.rows - 2 * depth;
+  const int count = depth * deepBoard.stride;
 
-    auto endTime = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
-    runTime += duration.count();
+  MPI_Sendrecv(deepBoard.row(depth) - 1, count, MPI_UINT8_T, prev, 2 * tag,                  // send
+               deepBoard.row(depth + ownRows) - 1, count, MPI_UINT8_T, next, 2 * tag,        // receive
+               MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+  MPI_Sendrecv(deepBoard.row(ownRows) - 1, count, MPI_UINT8_T, next, 2 * tag + 1,            // send
+               deepBoard.row(0) - 1, count, MPI_UINT8_T, prev, 2 * tag + 1,                  // receive
+               MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
 
-    if (rank == 0) {
-      // print the final board
-      outputFile << "\n";
-      printBoard(outputFile, board);
+// tuning: the halo depth that balances the message latency against the redundant rows it costs
+// (per generation, a depth of k costs latency / k for the messages, and about (k - 1) extra rows of compute, so the best k is
+// sqrt(latency / row time))
+int tuneHaloDepth(const int rank, const int numProcs, PaddedBoard &localBoard, const int maxDepth) {
+  int prev = (rank - 1 + numProcs) % numProcs;
+  int next = (rank + 1 + numProcs) % numProcs;
+  const int trials = 20;
+
+  // the latency of a round of single row halo messages
+  PaddedBoard trialBoard;
+  trialBoard.resize(localRows + 2, totalColumns);
+  MPI_Barrier(MPI_COMM_WORLD);
+  double start = MPI_Wtime();
+  for (int i = 0; i < trials; i++) exchangeDeepHalo(trialBoard, 1, prev, next, i);
+  double latency = (MPI_Wtime() - start) / trials;
+
+  // the time to update a row
+  PaddedBoard nextGeneration;
+  nextGeneration.resize(localRows, totalColumns);
+  localBoard.fillColumnHalo();
+  start = MPI_Wtime();
+  for (int i = 0; i < trials; i++) {
+    for (int row = 0; row < localRows; row++) {
+      nextRowPadded(localBoard.row(row - 1), localBoard.row(row), localBoard.row(row + 1), nextGeneration.row(row), totalColumns, rule);
     }
   }
+  double rowTime = (MPI_Wtime() - start) / trials / localRows;
+
+  // every process must use the same depth - use the slowest measurements
+  double measured[2] = {latency, rowTime}, slowest[2];
+  MPI_Allreduce(measured, slowest, 2, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
 
+  int depth = max(1, min(maxDepth, (int)round(sqrt(slowest[0] / max(slowest[1], 1e-9)))));
   if (rank == 0) {
-    printf("Parallel average run time: %.2fms\n", (double)runTime / averageIterations);
-    outputFile.close();
+    printf("Halo depth tuning: latency %.2fus, row update %.2fus, depth %d\n", slowest[0] * 1e6, slowest[1] * 1e6, depth);
+  }
+  return depth;
+}
+
+// play the game on a padded byte board with deep halos: depth rows are exchanged at once, and then depth generations are
+// played locally - each generation, one more row at each end of the halo becomes stale, so the rows that are updated shrink
+// until only our own rows are left (the halo rows are recomputed redundantly, instead of being communicated)
+void playGameDeepHalo(const int rank, const int numProcs, const int generations, const int depth, PaddedBoard &localBoard) {
+  // determine the communication partners
+  int prev = (rank - 1 + numProcs) % numProcs;
+  int next = (rank + 1 + numProcs) % numProcs;
+
+  // our rows, with depth rows of halo above and below them
+  const int deepRows = localRows + 2 * depth;
+  PaddedBoard deepBoard, nextGeneration;
+  deepBoard.resize(deepRows, totalColumns);
+  nextGeneration.resize(deepRows, totalColumns);
+  for (int row = 0; row < localRows; row++) {
+    memcpy(deepBoard.row(depth + row), localBoard.row(row), totalColumns);
+  }
+
+  // play the game
+  for (int i = 0; i < generations; i += depth) {
+    exchangeDeepHalo(deepBoard, depth, prev, next, i / depth);
+    haloMessages += 2;
+
+    const int steps = min(depth, generations - i);
+    for (int step = 0; step < steps; step++) {
+      // the wraparound within each row is local
+      deepBoard.fillColumnHalo();
+
+      // the outermost rows have no neighbours outside the deep board, so the valid rows shrink by one at each end
+      for (int row = step + 1; row < deepRows - step - 1; row++) {
+        nextRowPadded(deepBoard.row(row - 1), deepBoard.row(row), deepBoard.row(row + 1), nextGeneration.row(row), totalColumns, rule);
+      }
+
+      // have determined the next generation of the board - make it active
+      deepBoard.cells.swap(nextGeneration.cells);
+      if (snapshotDue(i + step + 1)) {
+        snapshots->record(i + step + 1, firstCellIndex / totalColumns, localRows,
+                          [&](const int r, uint8_t *bits) { packByteRow(deepBoard.row(depth + r), totalColumns, bits); });
+      }
+    }
   }
 
+  for (int row = 0; row < localRows; row++) {
+    memcpy(localBoard.row(row), deepBoard.row(depth + row), totalColumns);
+  }
+}
+
+// play the game on a padded byte board, only evaluating the tiles that (or whose neighbours) changed since two generations ago
+// the change flags of the boundary tile rows are exchanged first, and a halo row is only sent if its tile row changed since two generations ago
+void playGameTiled(const int rank, const int numProcs, const int generations, PaddedBoard &localBoard) {
+  // determine the communication partners
+  int prev = (rank - 1 + numProcs) % numProcs;
+  int next = (rank + 1 + numProcs) % numProcs;
+  const int stride = localBoard.stride;
+
+  PaddedBoard nextGeneration;
+  nextGeneration.resize(localRows, totalColumns);
+
+  ActiveTiles tiles;
+  tiles.resize(localRows, totalColumns);
+  tiles.rule = rule;
+  tiles.hashing = detectCycles;
+  tiles.firstCellIndex = firstCellIndex;
+  tiles.timing = rebalanceInterval > 0;
+  int lastTileRow = tiles.tileRows - 1;
+  vector<double> rowCosts(localRows);
+
+  CycleDetector<PaddedBoard> detector(generations, [](const PaddedBoard &a, const PaddedBoard &b) { return sameEverywhere(a.sameCells(b)); });
+  uint64_t hash = 0;
+
+  // the flags of the last tile row of the previous process, and the first tile row of the next process
+  vector<uint8_t> changedAbove(tiles.tileColumns), changedBelow(tiles.tileColumns);
+
+  // play the game
+  for (int i = 0; i < generations; i++) {
+    // the wraparound within each row is local
+    localBoard.fillColumnHalo();
+
+    // send the flags of the first tile row to the previous process, and of the last tile row to the next process
+    MPI_Sendrecv(tiles.tileRow(0), tiles.tileColumns, MPI_UINT8_T, prev, 4 * i,                      // send
+                 changedBelow.data(), tiles.tileColumns, MPI_UINT8_T, next, 4 * i,                   // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(tiles.tileRow(lastTileRow), tiles.tileColumns, MPI_UINT8_T, next, 4 * i + 1,  // send
+                 changedAbove.data(), tiles.tileColumns, MPI_UINT8_T, prev, 4 * i + 1,         // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+    // only the boundary rows that changed are exchanged - both sides know which from the flags
+    MPI_Request requests[4];
+    int numRequests = 0;
+    bool receiveBelow = any_of(changedBelow.begin(), changedBelow.end(), [](uint8_t flag) { return flag != 0; });
+    bool receiveAbove = any_of(changedAbove.begin(), changedAbove.end(), [](uint8_t flag) { return flag != 0; });
+
+    // (a halo row that is the same as two generations ago is already in this buffer, from two generations ago)
+    if (receiveBelow) {
+      MPI_Irecv(localBoard.row(localRows) - 1, stride, MPI_UINT8_T, next, 4 * i + 2, MPI_COMM_WORLD, &requests[numRequests++]);
+    }
+    if (receiveAbove) {
+      MPI_Irecv(localBoard.row(-1) - 1, stride, MPI_UINT8_T, prev, 4 * i + 3, MPI_COMM_WORLD, &requests[numRequests++]);
+    }
+    if (tiles.anyChanged(0)) {
+      MPI_Isend(localBoard.row(0) - 1, stride, MPI_UINT8_T, prev, 4 * i + 2, MPI_COMM_WORLD, &requests[numRequests++]);
+    }
+    if (tiles.anyChanged(lastTileRow)) {
+      MPI_Isend(localBoard.row(localRows - 1) - 1, stride, MPI_UINT8_T, next, 4 * i + 3, MPI_COMM_WORLD, &requests[numRequests++]);
+    }
+    MPI_Waitall(numRequests, requests, MPI_STATUSES_IGNORE);
+
+    tiles.step(localBoard, nextGeneration, changedAbove.data(), changedBelow.data());
+
+    // have determined the next generation of the board - make it active
+    localBoard.cells.swap(nextGeneration.cells);
+    if (detectCycles) {
+      hash ^= tiles.hashChange;
+      i += detector.observe(i + 1, boardHash(hash), localBoard);
+    }
+    if (snapshotDue(i + 1)) snapshots->recordPadded(i + 1, firstCellIndex / totalColumns, localRows, localBoard);
+
+    if (rebalanceDue(i, generations)) {
+      tileRowCosts(tiles, rowCosts);
+      fill(tiles.tileRowTimes.begin(), tiles.tileRowTimes.end(), 0);
+
+      // the new strips start again with every tile active (the neighbours' halo rows aren't in the buffers yet either)
+      if (rebalanceRows(rank, numProcs, i + 1, localBoard, rowCosts)) {
+        nextGeneration.resize(localRows, totalColumns);
+        tilesEvaluated += tiles.evaluated;
+        tilesConsidered += tiles.considered;
+        tiles.resize(localRows, totalColumns);
+        tiles.firstCellIndex = firstCellIndex;
+        lastTileRow = tiles.tileRows - 1;
+      }
+    }
+  }
+
+  if (detectCycles) recordCycle(detector);
+  if (rebalanceInterval > 0) {
+    rowCosts.resize(localRows);
+    tileRowCosts(tiles, rowCosts);
+    finishRebalancing(rowCosts, generations);
+  }
+
+  tilesEvaluated += tiles.evaluated;
+  tilesConsidered += tiles.considered;
+}
+
+// print the cell updates per second (n/a if the run was too short to time)
+void printCellUpdateRate(const char *version, const double cellUpdates, const double seconds) {
+  if (seconds > 0) {
+    printf("%s cell updates per second: %.3e\n", version, cellUpdates / seconds);
+  } else {
+    printf("%s cell updates per second: n/a\n", version);
+  }
+}
+
+// play an ensemble of boards (one per seed, from firstSeed) - each process takes the next seed from the counter on rank 0 until
+// every board is played, and summarises the boards it played
+void playEnsemble(const int rank, const int firstSeed, const int boards, const int generations, vector<BoardSummary> &summaries) {
+  int *counter;
+  MPI_Win window;
+  MPI_Win_allocate(rank == 0 ? sizeof(int) : 0, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &counter, &window);
+  if (rank == 0) *counter = 0;
+  MPI_Win_lock_all(0, window);
+  MPI_Barrier(MPI_COMM_WORLD);
+
+  EnsembleBoard ensembleBoard;
+  ensembleBoard.rule = rule;
+  ensembleBoard.detectCycles = detectCycles;
+  ensembleBoard.resize(totalRows, totalColumns);
+
+  const int one = 1;
+  while (true) {
+    int board;
+    MPI_Fetch_and_op(&one, &board, MPI_INT, 0, 0, MPI_SUM, window);
+    MPI_Win_flush(0, window);
+    if (board >= boards) break;
+    summaries.push_back(ensembleBoard.play((int64_t)firstSeed + board, generations));
+  }
+
+  MPI_Win_unlock_all(window);
+  MPI_Win_free(&window);
+}
+
+// play a Larger than Life rule - the halo is radius rows deep, and the counts come from running sums (see largerThanLife.h)
+void playGameLargerThanLife(const int rank, const int numProcs, const int generations, RadiusBoard &localBoard) {
+  // determine the communication partners
+  int prev = (rank - 1 + numProcs) % numProcs;
+  int next = (rank + 1 + numProcs) % numProcs;
+  const int haloCount = ltlRule.radius * totalColumns;
+
+  RadiusBoard nextGeneration;
+  nextGeneration.resize(localRows, totalColumns, ltlRule.radius);
+
+  LargerThanLife engine;
+  engine.rule = ltlRule;
+
+  CycleDetector<RadiusBoard> detector(generations, [](const RadiusBoard &a, const RadiusBoard &b) { return sameEverywhere(a.sameCells(b)); });
+  uint64_t hash = 0;
+
+  for (int i = 0; i < generations; i++) {
+    // our first rows are the previous process's bottom halo, and our last rows are the next process's top halo (the tags keep
+    // the two apart when a process is its own neighbour)
+    double waitStart = MPI_Wtime();
+    MPI_Sendrecv(localBoard.row(0), haloCount, MPI_UINT8_T, prev, 2 * i,                       // send
+                 localBoard.row(localRows), haloCount, MPI_UINT8_T, next, 2 * i,               // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(localBoard.row(localRows - ltlRule.radius), haloCount, MPI_UINT8_T, next, 2 * i + 1,  // send
+                 localBoard.row(-ltlRule.radius), haloCount, MPI_UINT8_T, prev, 2 * i + 1,              // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    haloWaitTime += MPI_Wtime() - waitStart;
+
+    engine.step(localBoard, nextGeneration);
+    if (detectCycles) {
+      for (int row = 0; row < localRows; row++) {
+        hash ^= hashByteChanges(localBoard.row(row), nextGeneration.row(row), totalColumns, firstCellIndex + (uint64_t)row * totalColumns);
+      }
+    }
+
+    // have determined the next generation of the board - make it active
+    localBoard.cells.swap(nextGeneration.cells);
+    if (detectCycles) i += detector.observe(i + 1, boardHash(hash), localBoard);
+    if (snapshotDue(i + 1)) snapshots->recordPadded(i + 1, firstCellIndex / totalColumns, localRows, localBoard);
+  }
+
+  if (detectCycles) recordCycle(detector);
+}
+
+// the first row/column of block i, when total rows/columns are split into parts blocks (the first total % parts blocks get an extra one)
+int blockStart(const int i, const int total, const int parts) {
+  return i * (total / parts) + min(i, total % parts);
+}
+
+// the rows and columns of the block of a process in the 2d grid
+void determineBlock(MPI_Comm cart, const int process, const int dims[2], int &firstRow, int &numRows, int &firstColumn, int &numColumns) {
+  int coords[2];
+  MPI_Cart_coords(cart, process, 2, coords);
+  firstRow = blockStart(coords[0], totalRows, dims[0]);
+  numRows = blockStart(coords[0] + 1, totalRows, dims[0]) - firstRow;
+  firstColumn = blockStart(coords[1], totalColumns, dims[1]);
+  numColumns = blockStart(coords[1] + 1, totalColumns, dims[1]) - firstColumn;
+}
+
+// the datatype of a block within the whole board (rank 0 sends/receives the blocks straight from/into the board)
+MPI_Datatype createBlockType(const int firstRow, const int numRows, const int firstColumn, const int numColumns) {
+  int sizes[2] = {totalRows, totalColumns};
+  int subsizes[2] = {numRows, numColumns};
+  int starts[2] = {firstRow, firstColumn};
+
+  MPI_Datatype block;
+  MPI_Type_create_subarray(2, sizes, subsizes, starts, MPI_ORDER_C, MPI_UINT8_T, &block);
+  MPI_Type_commit(&block);
+  return block;
+}
+
+// send every process its block of the board (rank 0), or receive this process's block
+void distributeBlocks(MPI_Comm cart, const int rank, const int numProcs, const int dims[2], const vector<uint8_t> &cells, vector<uint8_t> &localCells) {
+  int firstRow, numRows, firstColumn, numColumns;
+  if (rank != 0) {
+    MPI_Recv(localCells.data(), localCells.size(), MPI_UINT8_T, 0, 0, cart, MPI_STATUS_IGNORE);
+    return;
+  }
+
+  for (int p = 0; p < numProcs; p++) {
+    determineBlock(cart, p, dims, firstRow, numRows, firstColumn, numColumns);
+    if (p == 0) {
+      // our own block is just copied
+      for (int r = 0; r < numRows; r++) {
+        copy(cells.begin() + convertToIndex(firstRow + r, firstColumn), cells.begin() + convertToIndex(firstRow + r, firstColumn) + numColumns,
+             localCells.begin() + r * numColumns);
+      }
+      continue;
+    }
+
+    MPI_Datatype block = createBlockType(firstRow, numRows, firstColumn, numColumns);
+    MPI_Send(cells.data(), 1, block, p, 0, cart);
+    MPI_Type_free(&block);
+  }
+}
+
+// the reverse of distributeBlocks: rank 0 collects every block back into the board
+void collectBlocks(MPI_Comm cart, const int rank, const int numProcs, const int dims[2], vector<uint8_t> &cells, const vector<uint8_t> &localCells) {
+  int firstRow, numRows, firstColumn, numColumns;
+  if (rank != 0) {
+    MPI_Send(localCells.data(), localCells.size(), MPI_UINT8_T, 0, 1, cart);
+    return;
+  }
+
+  for (int p = 0; p < numProcs; p++) {
+    determineBlock(cart, p, dims, firstRow, numRows, firstColumn, numColumns);
+    if (p == 0) {
+      for (int r = 0; r < numRows; r++) {
+        copy(localCells.begin() + r * numColumns, localCells.begin() + (r + 1) * numColumns, cells.begin() + convertToIndex(firstRow + r, firstColumn));
+      }
+      continue;
+    }
+
+    MPI_Datatype block = createBlockType(firstRow, numRows, firstColumn, numColumns);
+    MPI_Recv(cells.data(), 1, block, p, 1, cart, MPI_STATUS_IGNORE);
+    MPI_Type_free(&block);
+  }
+}
+
+// the 8 directions to the neighbours in the 2d grid (opposite directions are 7 - direction apart)
+enum direction { NORTH_WEST, NORTH, NORTH_EAST, WEST, EAST, SOUTH_WEST, SOUTH, SOUTH_EAST };
+const int directionRow[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+const int directionColumn[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+
+// play the game on a block of the 2d grid - the halo (including the corners) comes from the 8 neighbouring blocks
+void playGame2D(MPI_Comm cart, const int rank, const int generations, PaddedBoard &localBoard) {
+  const int rows = localBoard.rows;
+  const int columns = localBoard.columns;
+
+  // the neighbours (the grid is periodic, so MPI_Cart_rank wraps the coordinates)
+  int coords[2], neighbours[8];
+  MPI_Cart_coords(cart, rank, 2, coords);
+  for (int d = 0; d < 8; d++) {
+    int neighbourCoords[2] = {coords[0] + directionRow[d], coords[1] + directionColumn[d]};
+    MPI_Cart_rank(cart, neighbourCoords, &neighbours[d]);
+  }
+
+  // a row is contiguous, a column is one cell per padded row, and a corner is a single cell
+  MPI_Datatype rowType, columnType;
+  MPI_Type_contiguous(columns, MPI_UINT8_T, &rowType);
+  MPI_Type_vector(rows, 1, localBoard.stride, MPI_UINT8_T, &columnType);
+  MPI_Type_commit(&rowType);
+  MPI_Type_commit(&columnType);
+  MPI_Datatype types[8] = {MPI_UINT8_T, rowType, MPI_UINT8_T, columnType, columnType, MPI_UINT8_T, rowType, MPI_UINT8_T};
+
+  PaddedBoard nextGeneration;
+  nextGeneration.resize(rows, columns);
+
+  for (int i = 0; i < generations; i++) {
+    // the cells we send in each direction (our edges), and the halo cells we receive from each direction
+    uint8_t *edges[8] = {localBoard.row(0),        localBoard.row(0),        localBoard.row(0) + columns - 1,
+                         localBoard.row(0),        localBoard.row(0) + columns - 1,
+                         localBoard.row(rows - 1), localBoard.row(rows - 1), localBoard.row(rows - 1) + columns - 1};
+    uint8_t *halos[8] = {localBoard.row(-1) - 1,  localBoard.row(-1),     localBoard.row(-1) + columns,
+                         localBoard.row(0) - 1,   localBoard.row(0) + columns,
+                         localBoard.row(rows) - 1, localBoard.row(rows), localBoard.row(rows) + columns};
+
+    // the tag is the direction the cells travel in, since the same process can be a neighbour in several directions
+    MPI_Request requests[16];
+    for (int d = 0; d < 8; d++) {
+      MPI_Irecv(halos[d], 1, types[d], neighbours[d], 7 - d, cart, &requests[d]);
+      MPI_Isend(edges[d], 1, types[d], neighbours[d], d, cart, &requests[8 + d]);
+    }
+    MPI_Waitall(16, requests, MPI_STATUSES_IGNORE);
+
+    for (int row = 0; row < rows; row++) {
+      nextRowPadded(localBoard.row(row - 1), localBoard.row(row), localBoard.row(row + 1), nextGeneration.row(row), columns, rule);
+    }
+
+    // have determined the next generation of the board - make it active
+    localBoard.cells.swap(nextGeneration.cells);
+  }
+
+  MPI_Type_free(&rowType);
+  MPI_Type_free(&columnType);
+}
+
+// play the game on this process's rows (stored as bytes), with any of the rows decomposition engines
+void playRows(const int rank, const int numProcs, const int generations, const string &engine, const string &haloMode, const int haloDepth,
+              vector<uint8_t> &localCells) {
+  if (snapshots != nullptr) snapshots->recordCells(0, firstCellIndex / totalColumns, localRows, localCells);
+
+  if (engine == "bitpacked") {
+    BitBoard localPacked;
+    localPacked.resize(localRows, totalColumns);
+    localPacked.pack(localCells);
+    playGameBitPacked(rank, numProcs, generations, localPacked);
+    localPacked.unpack(localCells);
+  } else if (engine == "ltl") {
+    RadiusBoard localLtl;
+    localLtl.resize(localRows, totalColumns, ltlRule.radius);
+    localLtl.load(localCells);
+    playGameLargerThanLife(rank, numProcs, generations, localLtl);
+    localLtl.store(localCells);
+  } else if (engine == "padded" || engine == "tiled") {
+    PaddedBoard localPadded;
+    localPadded.resize(localRows, totalColumns);
+    localPadded.load(localCells);
+
+    if (engine == "tiled") {
+      playGameTiled(rank, numProcs, generations, localPadded);
+    } else if (haloDepth > 1) {
+      playGameDeepHalo(rank, numProcs, generations, haloDepth, localPadded);
+    } else if (haloMode == "rma" || haloMode == "shared") {
+      playGameOneSided(rank, numProcs, generations, localPadded, haloMode == "shared");
+    } else {
+      playGamePadded(rank, numProcs, generations, localPadded);
+    }
+
+    // (rebalancing may have changed our rows)
+    localCells.resize(localRows * totalColumns);
+    localPadded.store(localCells);
+  } else {
+    vector<int> localBoard(localCells.begin(), localCells.end());
+    playGame(rank, numProcs, generations, localBoard, haloMode);
+    localCells.assign(localBoard.begin(), localBoard.end());
+  }
+}
+
+// write the board to a binary board file (see boardFile.h) - every process writes its own rows, collectively
+void writeBoardFile(const string &fileName, const int rank, const int firstRow, const vector<uint8_t> &localCells) {
+  MPI_File file;
+  MPI_File_open(MPI_COMM_WORLD, fileName.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+  MPI_File_set_size(file, 0);
+
+  if (rank == 0) {
+    uint8_t header[boardFileHeaderSize];
+    boardFileHeader(totalRows, totalColumns, header);
+    MPI_File_write_at(file, 0, header, boardFileHeaderSize, MPI_BYTE, MPI_STATUS_IGNORE);
+  }
+
+  // the rows are packed to bits, and each row is at a known offset
+  vector<uint8_t> bytes;
+  packBoardRows(localCells, localRows, totalColumns, bytes);
+  MPI_Offset offset = boardFileHeaderSize + (MPI_Offset)firstRow * boardFileRowBytes(totalColumns);
+  MPI_File_write_at_all(file, offset, bytes.data(), bytes.size(), MPI_BYTE, MPI_STATUS_IGNORE);
+
+  MPI_File_close(&file);
+}
+
+// play the counter-based board of a seed out of core (see outOfCore.h): rank 0 makes two board files in directory, each process
+// generates its rows into the first, and each generation streams its rows from one file into the other - the final board is left
+// in directory/parallel-output.bin
+// false (on every process) if the files can't be made
+bool playOutOfCore(const int rank, const int numProcs, const string &directory, const int seed, const int generations, OutOfCoreStrips &strips,
+                   uint64_t &population, double &initialiseTime) {
+  // determine the communication partners
+  int prev = (rank - 1 + numProcs) % numProcs;
+  int next = (rank + 1 + numProcs) % numProcs;
+  const int firstRow = blockStart(rank, totalRows, numProcs);
+
+  const string fileNames[2] = {directory + "/parallel-board-0.bin", directory + "/parallel-board-1.bin"};
+  int created = rank != 0 || (createBoardFile(fileNames[0], totalRows, totalColumns) && createBoardFile(fileNames[1], totalRows, totalColumns));
+  MPI_Bcast(&created, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (!created) return false;
+
+  MappedBoard boards[2];
+  int mapped = boards[0].map(fileNames[0], totalRows, totalColumns, firstRow, localRows) &&
+               boards[1].map(fileNames[1], totalRows, totalColumns, firstRow, localRows);
+  MPI_Allreduce(MPI_IN_PLACE, &mapped, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+  if (!mapped) return false;
+
+  double startTime = MPI_Wtime();
+  population = strips.initialise(boards[0], seed);
+  initialiseTime = MPI_Wtime() - startTime;
+
+  const int rowBytes = boards[0].rowBytes;
+  vector<uint8_t> above(rowBytes), below(rowBytes);
+  int current = 0;
+  for (int i = 0; i < generations; i++) {
+    // our first row is the previous process's bottom halo, and our last row is the next process's top halo (the tags keep the
+    // two apart when a process is its own neighbour)
+    double waitStart = MPI_Wtime();
+    MPI_Sendrecv(boards[current].row(firstRow), rowBytes, MPI_UINT8_T, prev, 2 * i,                   // send
+                 below.data(), rowBytes, MPI_UINT8_T, next, 2 * i,                                    // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    MPI_Sendrecv(boards[current].row(firstRow + localRows - 1), rowBytes, MPI_UINT8_T, next, 2 * i + 1,  // send
+                 above.data(), rowBytes, MPI_UINT8_T, prev, 2 * i + 1,                                 // receive
+                 MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    haloWaitTime += MPI_Wtime() - waitStart;
+
+    population = strips.play(boards[current], boards[1 - current], above.data(), below.data());
+    current = 1 - current;
+  }
+
+  // every process's rows are written before the files are swapped for the output
+  boards[0].unmap();
+  boards[1].unmap();
+  MPI_Barrier(MPI_COMM_WORLD);
+  int renamed = 1;
+  if (rank == 0) {
+    remove(fileNames[1 - current].c_str());
+    renamed = rename(fileNames[current].c_str(), (directory + "/" + binaryOutputFileName).c_str()) == 0;
+  }
+  MPI_Bcast(&renamed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  return renamed;
+}
+
+int main(int argc, char *argv[]) {
+  // initialise mpi environment
+  MPI_Init(&argc, &argv);
+
+  int rank, numProcs;
+
+  // get the number of processes and this process's rank
+  MPI_Comm_size(MPI_COMM_WORLD, &numProcs);
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+  // check we have the arguments we need
+  string engine = "naive";
+  string decomposition = "rows";
+  string haloMode = "blocking";
+  string haloDepthOption = "1";
+  string init = "seed";
+  string patternFileName, saveFileName;
+  int atRow = 0, atColumn = 0;
+  int ensembleBoards = 0;
+  string outOfCoreDirectory;
+  bool usageError = argc < 5;
+  for (int i = 5; i < argc && !usageError; i++) {
+    string option(argv[i]);
+    if (option == "--engine" && i + 1 < argc) {
+      engine = argv[++i];
+    } else if (option == "--decomposition" && i + 1 < argc) {
+      decomposition = argv[++i];
+    } else if (option == "--halo" && i + 1 < argc) {
+      haloMode = argv[++i];
+    } else if (option == "--halo-depth" && i + 1 < argc) {
+      haloDepthOption = argv[++i];
+      usageError = haloDepthOption != "auto" && atoi(haloDepthOption.c_str()) < 1;
+    } else if (option == "--init" && i + 1 < argc) {
+      init = argv[++i];
+    } else if (option == "--pattern" && i + 1 < argc) {
+      patternFileName = argv[++i];
+    } else if (option == "--at" && i + 2 < argc) {
+      atRow = atoi(argv[++i]);
+      atColumn = atoi(argv[++i]);
+      usageError = atRow < 0 || atColumn < 0;
+    } else if (option == "--save" && i + 1 < argc) {
+      saveFileName = argv[++i];
+    } else if (option == "--rule" && i + 1 < argc) {
+      largerThanLife = isLargerThanLifeRule(argv[++i]);
+      usageError = largerThanLife ? !ltlRule.parse(argv[i]) : !rule.parse(argv[i]);
+    } else if (option == "--detect-cycles") {
+      detectCycles = true;
+    } else if (option == "--rebalance" && i + 1 < argc) {
+      rebalanceInterval = atoi(argv[++i]);
+      usageError = rebalanceInterval < 1;
+    } else if (option == "--snapshots" && i + 1 < argc) {
+      snapshotInterval = atoi(argv[++i]);
+      usageError = snapshotInterval < 1;
+    } else if (option == "--ensemble" && i + 1 < argc) {
+      ensembleBoards = atoi(argv[++i]);
+      usageError = ensembleBoards < 1;
+    } else if (option == "--out-of-core" && i + 1 < argc) {
+      outOfCoreDirectory = argv[++i];
+    } else {
+      usageError = true;
+    }
+  }
+
+  if (usageError || (engine != "naive" && engine != "bitpacked" && engine != "padded" && engine != "tiled" && engine != "ltl") ||
+      (decomposition != "rows" && decomposition != "2d") || (haloMode != "blocking" && haloMode != "nonblocking" && haloMode != "persistent" && haloMode != "rma" && haloMode != "shared") || (init != "seed" && init != "counter")) {
+    if (rank == 0) {
+      printf(
+          "Usage: %s <rows> <columns> <seed> <generation> <OPTIONAL: --engine [naive/bitpacked/padded/tiled/ltl]> <OPTIONAL: --decomposition [rows/2d]> "
+          "<OPTIONAL: --halo [blocking/nonblocking/persistent/rma/shared]> <OPTIONAL: --halo-depth [<rows>/auto]> <OPTIONAL: --init [seed/counter]>\n"
+          "       <OPTIONAL: --pattern <file (rle/plaintext)>> <OPTIONAL: --at <row> <column>> <OPTIONAL: --save <file (.rle/.cells)>>\n"
+          "       <OPTIONAL: --rule <B.../S..., e.g. B36/S23, or Larger than Life for the ltl engine, e.g. R5,C0,M1,S34..58,B34..45,NM>> <OPTIONAL: --detect-cycles> <OPTIONAL: --rebalance <generations>>\n"
+          "       <OPTIONAL: --snapshots <generations between snapshots>> <OPTIONAL: --ensemble <boards (one per seed, from the seed)>> <OPTIONAL: --out-of-core <directory for the board files>>\n",
+          argv[0]);
+    }
+    MPI_Finalize();
+    return 0;
+  }
+
+  // the 2d decomposition exchanges its halo straight into the padding of the padded board
+  if (decomposition == "2d" && engine != "padded") {
+    if (rank == 0) printf("The 2d decomposition uses the padded engine: add --engine padded\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // each process initialises its own rows, so the board is never gathered - it is written to a binary file instead
+  if (init == "counter" && decomposition != "rows") {
+    if (rank == 0) printf("The distributed (counter) initialisation is only available with the rows decomposition\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // patterns are placed on (and saved from) the whole board, which only rank 0 holds
+  if (init == "counter" && (!patternFileName.empty() || !saveFileName.empty())) {
+    if (rank == 0) printf("Patterns can't be loaded or saved with the distributed (counter) initialisation\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // Create and open a text file
+  ofstream outputFile;
+  if (rank == 0 && init == "seed") {
+    outputFile.open(outputFileName);
+  }
+
+  // get the arguments
+  totalRows = atoi(argv[1]);
+  totalColumns = atoi(argv[2]);
+  int seed = atoi(argv[3]);
+  int generations = atoi(argv[4]);
+
+  // the halo modes overlap the exchange with the naive engine's per-cell updates
+  if ((haloMode == "nonblocking" || haloMode == "persistent") && (engine != "naive" || decomposition != "rows")) {
+    if (rank == 0) printf("The %s halo mode is only available with the naive engine and the rows decomposition\n", haloMode.c_str());
+    MPI_Finalize();
+    return 0;
+  }
+
+  // the one-sided halo modes put (or read) rows straight into (or from) the padding of the neighbours' padded boards
+  if ((haloMode == "rma" || haloMode == "shared") &&
+      (engine != "padded" || decomposition != "rows" || haloDepthOption != "1" || detectCycles || rebalanceInterval > 0)) {
+    if (rank == 0) {
+      printf("The %s halo mode is only available with the padded engine, the rows decomposition and a halo depth of 1 (without cycle detection or rebalancing)\n",
+             haloMode.c_str());
+    }
+    MPI_Finalize();
+    return 0;
+  }
+
+  // deep halos are received straight into the padding of the padded board
+  if (haloDepthOption != "1" && (engine != "padded" || decomposition != "rows")) {
+    if (rank == 0) printf("Deep halos are only available with the padded engine and the rows decomposition\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // the cycle detection hashes whole rows
+  if (detectCycles && (decomposition != "rows" || haloDepthOption != "1")) {
+    if (rank == 0) printf("Cycle detection is only available with the rows decomposition and a halo depth of 1\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // rebalancing moves padded rows between the processes, and a row can't be split
+  if (rebalanceInterval > 0 && ((engine != "padded" && engine != "tiled") || decomposition != "rows" || haloDepthOption != "1" || detectCycles)) {
+    if (rank == 0) printf("Rebalancing is only available with the padded or tiled engine, the rows decomposition and a halo depth of 1 (without cycle detection)\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // each process streams its own rows (the strips of the rows decomposition), and cycle detection skips generations
+  if (snapshotInterval > 0 && (decomposition != "rows" || detectCycles)) {
+    if (rank == 0) printf("Snapshots are only available with the rows decomposition (without cycle detection)\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // Larger than Life rules have their own engine (and it only plays them - B3/S23 is a radius 1 rule too)
+  if (largerThanLife != (engine == "ltl") && (largerThanLife || !rule.isConway())) {
+    if (rank == 0) printf("Larger than Life rules are played by the ltl engine (and only them): add --engine ltl, or give the rule in Larger than Life notation\n");
+    MPI_Finalize();
+    return 0;
+  }
+  if (engine == "ltl") largerThanLife = true;
+
+  // the ltl engine exchanges radius rows deep halos with the processes above and below
+  if (engine == "ltl" && (decomposition != "rows" || haloMode != "blocking" || haloDepthOption != "1" || rebalanceInterval > 0)) {
+    if (rank == 0) printf("The ltl engine is only available with the rows decomposition and the default halo exchange (without rebalancing)\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  // a cell can't be in its own neighbourhood twice, and the halo rows only come from the neighbouring processes
+  if (engine == "ltl" && (totalRows < 2 * ltlRule.radius + 1 || totalColumns < 2 * ltlRule.radius + 1 || totalRows / numProcs < ltlRule.radius)) {
+    if (rank == 0) {
+      printf("Please choose a board of at least %d x %d, and at least %d rows per process, for a radius of %d\n", 2 * ltlRule.radius + 1,
+             2 * ltlRule.radius + 1, ltlRule.radius, ltlRule.radius);
+    }
+    MPI_Finalize();
+    return 0;
+  }
+
+  // the ensemble plays each board whole, with the padded engine, from its seed (with the counter-based initialisation), and only
+  // summarises the final boards
+  if (ensembleBoards > 0 && ((engine != "naive" && engine != "padded") || largerThanLife || decomposition != "rows" || haloMode != "blocking" ||
+                             haloDepthOption != "1" || rebalanceInterval > 0 || !patternFileName.empty() || !saveFileName.empty() || snapshotInterval > 0)) {
+    if (rank == 0) printf("The ensemble plays B/S rules with the padded engine, a whole board per process (without patterns, snapshots or the row options)\n");
+    MPI_Finalize();
+    return 0;
+  }
+
+  if (ensembleBoards > 0) {
+    vector<BoardSummary> summaries;
+    MPI_Barrier(MPI_COMM_WORLD);
+    double startTime = MPI_Wtime();
+    playEnsemble(rank, seed, ensembleBoards, generations, summaries);
+
+    // gather the summaries (as bytes - they're plain integers)
+    int summaryBytes = summaries.size() * sizeof(BoardSummary);
+    vector<int> counts(numProcs), displs(numProcs);
+    MPI_Gather(&summaryBytes, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    vector<BoardSummary> allSummaries(rank == 0 ? ensembleBoards : 0);
+    for (int p = 1; p < numProcs; p++) displs[p] = displs[p - 1] + counts[p - 1];
+    MPI_Gatherv(summaries.data(), summaryBytes, MPI_BYTE, allSummaries.data(), counts.data(), displs.data(), MPI_BYTE, 0, MPI_COMM_WORLD);
+    const double seconds = MPI_Wtime() - startTime;
+
+    if (rank == 0) {
+      ofstream ensembleFile(ensembleFileName);
+      writeEnsembleSummaries(ensembleFile, allSummaries);
+      EnsembleStatistics statistics(allSummaries);
+
+      if (!rule.isConway()) {
+        printf("Parallel rule: %s\n", rule.toString().c_str());
+      }
+      printf("Parallel ensemble: %d boards of %d x %d (seeds %d to %d), %d generations, %d processes\n", ensembleBoards, totalRows, totalColumns,
+             seed, seed + ensembleBoards - 1, generations, numProcs);
+      printf("Parallel ensemble run time: %.2fms\n", seconds * 1000);
+      printf("Parallel boards per second: %.2f\n", ensembleBoards / seconds);
+      printCellUpdateRate("Parallel", (double)totalRows * totalColumns * generations * ensembleBoards, seconds);
+      printf("Parallel boards per process:");
+      for (int p = 0; p < numProcs; p++) printf(" %d", counts[p] / (int)sizeof(BoardSummary));
+      printf("\n");
+      printf("Parallel ensemble population (min, mean, max): %lld, %.1f, %lld\n", (long long)statistics.minPopulation, statistics.meanPopulation,
+             (long long)statistics.maxPopulation);
+      printf("Parallel ensemble hash: %016llx (summaries in %s)\n", (unsigned long long)statistics.hash, ensembleFileName.c_str());
+      if (detectCycles) {
+        int64_t settled = 0;
+        for (auto &period : statistics.periods) settled += period.second;
+        printf("Parallel ensemble cycles: %lld of %d boards settled (up to period %d)", (long long)settled, ensembleBoards, defaultMaxPeriod);
+        for (auto &period : statistics.periods) printf(", period %lld: %lld", (long long)period.first, (long long)period.second);
+        printf("\n");
+      }
+      if (init == "seed") outputFile.close();
+    }
+
+    MPI_Finalize();
+    return 0;
+  }
+
+  // every process needs at least one row
+  if (decomposition == "rows" && totalRows < numProcs) {
+    if (rank == 0) printf("Please choose a board of at least %d rows for %d processes\n", numProcs, numProcs);
+    MPI_Finalize();
+    return 0;
+  }
+
+  // an out-of-core board is never in memory: it's the counter-based board of the seed, played by the bit-packed kernel a strip at
+  // a time, and only written out as a board file
+  if (!outOfCoreDirectory.empty() && ((engine != "naive" && engine != "bitpacked") || init != "counter" || largerThanLife || decomposition != "rows" ||
+                                      haloMode != "blocking" || haloDepthOption != "1" || rebalanceInterval > 0 || detectCycles ||
+                                      snapshotInterval > 0 || ensembleBoards > 0)) {
+    if (rank == 0) {
+      printf("Out-of-core boards are played by the bitpacked engine from --init counter, with the rows decomposition and the default halo exchange "
+             "(without cycle detection, rebalancing, snapshots or the ensemble)\n");
+    }
+    MPI_Finalize();
+    return 0;
+  }
+
+  if (!outOfCoreDirectory.empty()) {
+    localRows = blockStart(rank + 1, totalRows, numProcs) - blockStart(rank, totalRows, numProcs);
+    OutOfCoreStrips strips;
+    strips.rule = rule;
+    strips.resize(localRows, totalColumns);
+
+    // a single run: the board can be far bigger than memory, so it isn't played averageIterations times
+    uint64_t population = 0;
+    double initialiseTime = 0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    double startTime = MPI_Wtime();
+    const bool played = playOutOfCore(rank, numProcs, outOfCoreDirectory, seed, generations, strips, population, initialiseTime);
+    double seconds = MPI_Wtime() - startTime;
+    if (!played) {
+      if (rank == 0) printf("Couldn't make the board files in %s\n", outOfCoreDirectory.c_str());
+      MPI_Finalize();
+      return 0;
+    }
+
+    // the slowest process's times
+    uint64_t totalPopulation = 0;
+    double totalHaloWaitTime = 0, maxTimes[2] = {initialiseTime, seconds - initialiseTime}, slowestTimes[2];
+    MPI_Reduce(&population, &totalPopulation, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&haloWaitTime, &totalHaloWaitTime, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(maxTimes, slowestTimes, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+      const double boardBytes = (double)totalRows * boardFileRowBytes(totalColumns);
+      if (!rule.isConway()) {
+        printf("Parallel rule: %s\n", rule.toString().c_str());
+      }
+      printf("Parallel out-of-core board: %d x %d (%.2f MiB per board file), strips of up to %d rows per process (a window of %.2f MiB)\n", totalRows,
+             totalColumns, boardBytes / 1048576.0, strips.stripRows, 3.0 * strips.stripRows * strips.wordsPerRow * 8 / 1048576.0);
+      printf("Parallel out-of-core initialisation time: %.2fms\n", slowestTimes[0] * 1000);
+      printf("Parallel out-of-core run time: %.2fms\n", slowestTimes[1] * 1000);
+      printCellUpdateRate("Parallel", (double)totalRows * totalColumns * generations, slowestTimes[1]);
+      printf("Parallel board streaming rate: %.2f MiB/s (read and written, over every process)\n",
+             2 * boardBytes * generations / slowestTimes[1] / 1048576.0);
+      printf("Parallel halo wait time per process (%s): %.2fms\n", haloMode.c_str(), totalHaloWaitTime * 1000 / numProcs);
+      printf("Parallel final population: %llu (board in %s/%s)\n", (unsigned long long)totalPopulation, outOfCoreDirectory.c_str(),
+             binaryOutputFileName.c_str());
+    }
+
+    MPI_Finalize();
+    return 0;
+  }
+
+  // the periodic 2d grid of processes (for the 2d decomposition)
+  MPI_Comm cart = MPI_COMM_NULL;
+  int dims[2] = {0, 0};
+  if (decomposition == "2d") {
+    int periods[2] = {1, 1};
+    MPI_Dims_create(numProcs, 2, dims);
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &cart);
+
+    if (totalRows < dims[0] || totalColumns < dims[1]) {
+      if (rank == 0) printf("Please choose a board of at least %d x %d for a %d x %d grid of processes\n", dims[0], dims[1], dims[0], dims[1]);
+      MPI_Comm_free(&cart);
+      MPI_Finalize();
+      return 0;
+    }
+  }
+
+  // deep halos: the halo rows only come from the neighbouring processes, so the depth can't be more than the rows of any process
+  int haloDepth = 1;
+  if (haloDepthOption != "1") {
+    localRows = blockStart(rank + 1, totalRows, numProcs) - blockStart(rank, totalRows, numProcs);
+
+    int maxDepth;
+    MPI_Allreduce(&localRows, &maxDepth, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+    if (haloDepthOption == "auto") {
+      PaddedBoard trialBoard;
+      trialBoard.resize(localRows, totalColumns);
+      haloDepth = tuneHaloDepth(rank, numProcs, trialBoard, maxDepth);
+    } else {
+      haloDepth = min(atoi(haloDepthOption.c_str()), maxDepth);
+    }
+  }
+
+  // the initial board from a pattern file, placed on an empty board (rank 0 reads it, and tells the others if it failed)
+  vector<int> patternBoard;
+  if (!patternFileName.empty()) {
+    int placed = 1;
+    if (rank == 0) {
+      patternBoard.resize(totalRows * totalColumns);
+      placed = placePattern(patternFileName, atRow, atColumn, patternBoard);
+    }
+    MPI_Bcast(&placed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (!placed) {
+      MPI_Finalize();
+      return 0;
+    }
+  }
+
+  u_int64_t runTime = 0;
+  int haloCells = 0;
+
+  // the snapshot statistics of this process, over every run (each run rewrites the snapshot files)
+  const string snapshotFileName = snapshotFilePrefix + to_string(rank) + ".gol";
+  uint64_t snapshotCount = 0, snapshotBytes[2] = {0, 0};
+  double snapshotTimes[2] = {0, 0};  // stall, and writing the queue after the run
+  int snapshotsDirect = 0;
+
+  // the distributed initialisation: this process's rows (after the last run), and their hashes
+  vector<uint8_t> finalCells;
+  int firstRow = 0;
+  uint64_t initialHash = 0, finalHash = 0;
+
+  for (int _ = 0; _ < averageIterations; _++) {
+    // first process will generate the game board and then distribute it
+    vector<int> board, localBoard;
+    if (rank == 0 && init == "seed") {
+      board.resize(totalRows * totalColumns);
+
+      // initialise the board using the seed
+      if (!patternFileName.empty()) {
+        board = patternBoard;
+      } else {
+        srand(seed);
+        for (int i = 0; i < board.size(); i++) {
+          int value = ((double)rand() / RAND_MAX) >= 0.5 ? 1 : 0;
+          board[i] = value;
+        }
+      }
+
+      // print the initial board
+      outputFile << "\n";
+      printBoard(outputFile, board);
+    }
+
+    unique_ptr<SnapshotStream> stream;
+    if (snapshotInterval > 0) {
+      stream.reset(new SnapshotStream(snapshotFileName, totalColumns));
+      snapshots = stream.get();
+    }
+
+    auto startTime = chrono::high_resolution_clock::now();
+
+    // determine the number of rows per process (the first totalRows % numProcs processes get an extra row)
+    firstRow = blockStart(rank, totalRows, numProcs);
+    localRows = blockStart(rank + 1, totalRows, numProcs) - firstRow;
+    firstCellIndex = (uint64_t)firstRow * totalColumns;
+
+    // distribute the rows
+    // determine the number of elements to send to each process, and the offset in the vector
+    int sendcounts[numProcs];
+    int displs[numProcs];
+    for (int i = 0; i < numProcs; i++) {
+      displs[i] = blockStart(i, totalRows, numProcs) * totalColumns;
+      sendcounts[i] = blockStart(i + 1, totalRows, numProcs) * totalColumns - displs[i];
+    }
+
+    if (init == "counter") {
+      // every process generates its own rows - the value of a cell only depends on the seed and its index on the board
+      vector<uint8_t> localCells(localRows * totalColumns);
+      const uint64_t firstIndex = (uint64_t)firstRow * totalColumns;
+      for (int i = 0; i < localCells.size(); i++) {
+        localCells[i] = counterCell(seed, firstIndex + i);
+      }
+      initialHash = hashCells(localCells, localCells.size(), firstIndex);
+
+      // play the game
+      playRows(rank, numProcs, generations, engine, haloMode, haloDepth, localCells);
+
+      // (rebalancing may have moved our rows)
+      firstRow = firstCellIndex / totalColumns;
+      finalHash = hashCells(localCells, localCells.size(), firstCellIndex);
+      finalCells.swap(localCells);
+    } else if (decomposition == "2d") {
+      // distribute the blocks as bytes, then copy them into the padded board
+      int firstRow, numRows, firstColumn, numColumns;
+      determineBlock(cart, rank, dims, firstRow, numRows, firstColumn, numColumns);
+
+      vector<uint8_t> cells, localCells(numRows * numColumns);
+      if (rank == 0) cells.assign(board.begin(), board.end());
+      distributeBlocks(cart, rank, numProcs, dims, cells, localCells);
+
+      PaddedBoard localPadded;
+      localPadded.resize(numRows, numColumns);
+      localPadded.load(localCells);
+
+      // the perimeter of the block (its 4 edges and 4 corners)
+      haloCells = 2 * numRows + 2 * numColumns + 4;
+
+      // play the game
+      playGame2D(cart, rank, generations, localPadded);
+
+      // gather the blocks
+      localPadded.store(localCells);
+      collectBlocks(cart, rank, numProcs, dims, cells, localCells);
+
+      if (rank == 0) board.assign(cells.begin(), cells.end());
+    } else if (engine == "bitpacked") {
+      // the rows are distributed packed, so the counts and offsets are in words instead of cells
+      BitBoard packedBoard, localPacked;
+      const int wordsPerRow = (totalColumns + 63) / 64;
+      for (int i = 0; i < numProcs; i++) {
+        sendcounts[i] = sendcounts[i] / totalColumns * wordsPerRow;
+        displs[i] = displs[i] / totalColumns * wordsPerRow;
+      }
+
+      if (rank == 0) {
+        packedBoard.resize(totalRows, totalColumns);
+        packedBoard.pack(board);
+      }
+      localPacked.resize(localRows, totalColumns);
+
+      // distribute the rows
+      MPI_Scatterv(packedBoard.words.data(), sendcounts, displs, MPI_UINT64_T, localPacked.words.data(), localPacked.words.size(), MPI_UINT64_T, 0,
+                   MPI_COMM_WORLD);
+
+      // play the game
+      if (snapshots != nullptr) snapshots->recordBits(0, firstRow, localRows, localPacked);
+      playGameBitPacked(rank, numProcs, generations, localPacked);
+
+      // gather the localBoards
+      MPI_Gatherv(localPacked.words.data(), localPacked.words.size(), MPI_UINT64_T, packedBoard.words.data(), sendcounts, displs, MPI_UINT64_T, 0,
+                  MPI_COMM_WORLD);
+
+      if (rank == 0) {
+        packedBoard.unpack(board);
+      }
+    } else if (engine == "padded" || engine == "tiled" || engine == "ltl") {
+      // distribute the rows as bytes, then copy them into the padded board
+      vector<uint8_t> cells, localCells(localRows * totalColumns);
+      if (rank == 0) cells.assign(board.begin(), board.end());
+
+      MPI_Scatterv(cells.data(), sendcounts, displs, MPI_UINT8_T, localCells.data(), localCells.size(), MPI_UINT8_T, 0, MPI_COMM_WORLD);
+
+      // play the game
+      playRows(rank, numProcs, generations, engine, haloMode, haloDepth, localCells);
+
+      // gather the localBoards (from wherever rebalancing left the boundaries)
+      if (rebalanceInterval > 0) gatherCounts(numProcs, sendcounts, displs);
+      MPI_Gatherv(localCells.data(), localCells.size(), MPI_UINT8_T, cells.data(), sendcounts, displs, MPI_UINT8_T, 0, MPI_COMM_WORLD);
+
+      if (rank == 0) board.assign(cells.begin(), cells.end());
+    } else {
+      // resize the local boards to hold the appropriate number of cells
+      localBoard.resize(localRows * totalColumns);
+
+      // distribute the rows
+      MPI_Scatterv(board.data(), sendcounts, displs, MPI_INT, localBoard.data(), localRows * totalColumns, MPI_INT, 0, MPI_COMM_WORLD);
+
+      // play the game
+      if (snapshots != nullptr) snapshots->recordCells(0, firstRow, localRows, localBoard);
+      playGame(rank, numProcs, generations, localBoard, haloMode);
+
+      // gather the localBoards
+      MPI_Gatherv(localBoard.data(), localRows * totalColumns, MPI_INT, board.data(), sendcounts, displs, MPI_INT, 0, MPI_COMM_WORLD);
+    }
+
+    auto endTime = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::microseconds>(endTime - startTime);
+    runTime += duration.count();
+
+    // the snapshots still queued are written after the run (the time it takes is how far the writer fell behind)
+    if (stream) {
+      auto drainStart = chrono::high_resolution_clock::now();
+      stream->close();
+      snapshotTimes[1] += chrono::duration<double>(chrono::high_resolution_clock::now() - drainStart).count();
+      int written = stream->good(), allWritten;
+      MPI_Allreduce(&written, &allWritten, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+      if (!allWritten) {
+        if (!written) printf("Couldn't write the snapshots to %s\n", snapshotFileName.c_str());
+        MPI_Finalize();
+        return 0;
+      }
+      snapshotCount = stream->snapshots;
+      snapshotBytes[0] = stream->packedBytes;
+      snapshotBytes[1] = stream->writtenBytes;
+      snapshotTimes[0] += stream->stallTime;
+      snapshotsDirect = stream->direct;
+      snapshots = nullptr;
+    }
+
+    if (rank == 0 && init == "seed") {
+      // print the final board
+      outputFile << "\n";
+      printBoard(outputFile, board);
+
+      if (!saveFileName.empty() && _ == averageIterations - 1) {
+        savePattern(saveFileName, board);
+      }
+    }
+  }
+
+  // the distributed initialisation: write the final board, and check it with the hashes (without gathering it)
+  vector<uint64_t> processHashes(numProcs);
+  uint64_t boardHashes[2];
+  if (init == "counter") {
+    writeBoardFile(binaryOutputFileName, rank, firstRow, finalCells);
+
+    uint64_t hashes[2] = {initialHash, finalHash};
+    MPI_Reduce(hashes, boardHashes, 2, MPI_UINT64_T, MPI_BXOR, 0, MPI_COMM_WORLD);
+    MPI_Gather(&finalHash, 1, MPI_UINT64_T, processHashes.data(), 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+  }
+
+  // the fraction of tiles evaluated, over every process
+  uint64_t tileCounts[2] = {tilesEvaluated, tilesConsidered}, totalTileCounts[2];
+  MPI_Reduce(tileCounts, totalTileCounts, 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  // the average time a process spent waiting for its halo
+  double totalHaloWaitTime;
+  MPI_Reduce(&haloWaitTime, &totalHaloWaitTime, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  // the largest halo of any process
+  int maxHaloCells;
+  MPI_Reduce(&haloCells, &maxHaloCells, 1, MPI_INT, MPI_MAX, 0, MPI_COMM_WORLD);
+
+  // the compute time of every process, before and after rebalancing, and the rows they sent
+  double loads[2] = {timeBeforeRebalancing, timeAfterRebalancing};
+  vector<double> processLoads(2 * numProcs);
+  uint64_t totalRowsMigrated;
+  MPI_Gather(loads, 2, MPI_DOUBLE, processLoads.data(), 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&rowsMigrated, &totalRowsMigrated, 1, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+
+  // the snapshots of every process, and the average and longest time a process waited for (or after) its writer
+  uint64_t totalSnapshotBytes[2];
+  double totalSnapshotTimes[2], maxSnapshotTimes[2];
+  int allSnapshotsDirect;
+  MPI_Reduce(snapshotBytes, totalSnapshotBytes, 2, MPI_UINT64_T, MPI_SUM, 0, MPI_COMM_WORLD);
+  MPI_Reduce(snapshotTimes, totalSnapshotTimes, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  MPI_Reduce(snapshotTimes, maxSnapshotTimes, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&snapshotsDirect, &allSnapshotsDirect, 1, MPI_INT, MPI_MIN, 0, MPI_COMM_WORLD);
+
+  if (rank == 0) {
+    if (largerThanLife || !rule.isConway()) {
+      printf("Parallel rule: %s\n", ruleString().c_str());
+    }
+    printf("Parallel average run time: %.2fms\n", (double)runTime / 1000 / averageIterations);
+    printCellUpdateRate("Parallel", (double)totalRows * totalColumns * generations, (double)runTime / averageIterations / 1000000);
+    if ((engine == "naive" || engine == "padded" || engine == "ltl") && decomposition == "rows" && haloDepth == 1) {
+      printf("Parallel halo wait time per process (%s): %.2fms\n", haloMode.c_str(), totalHaloWaitTime * 1000 / numProcs / averageIterations);
+    }
+    if (detectCycles && cyclePeriod > 0) {
+      printf("Parallel cycle: period %d from generation %d (confirmed at generation %d, %d generations skipped)\n", cyclePeriod, cycleStart,
+             cycleConfirmedAt, cycleSkipped);
+    } else if (detectCycles) {
+      printf("Parallel cycle: none found (up to period %d)\n", defaultMaxPeriod);
+    }
+    if (engine == "tiled") {
+      printf("Parallel tiles evaluated per generation: %.2f%%\n", totalTileCounts[1] == 0 ? 0.0 : 100.0 * totalTileCounts[0] / totalTileCounts[1]);
+    }
+    if (rebalanceInterval > 0) {
+      // the imbalance is the slowest process's time over the average (1 is perfectly balanced)
+      const char *stages[2] = {"before", "after"};
+      for (int stage = 0; stage < 2; stage++) {
+        double slowest = 0, total = 0;
+        printf("Parallel compute time per generation per process %s rebalancing:", stages[stage]);
+        for (int p = 0; p < numProcs; p++) {
+          const double load = processLoads[2 * p + stage];
+          printf(" %.2fus", load * 1e6);
+          slowest = max(slowest, load);
+          total += load;
+        }
+        printf(" (imbalance %.2f)\n", total == 0 ? 1.0 : slowest * numProcs / total);
+      }
+      printf("Parallel rebalancing: every %d generations, %llu rebalances and %llu rows migrated per run\n", rebalanceInterval,
+             (unsigned long long)(rebalances / averageIterations), (unsigned long long)(totalRowsMigrated / averageIterations));
+    }
+    if (snapshotInterval > 0) {
+      printf("Parallel snapshots: every %d generations, %llu per run to %s<rank>.gol (%.2f MiB packed, %.2f MiB written over every process%s)\n",
+             snapshotInterval, (unsigned long long)snapshotCount, snapshotFilePrefix.c_str(), totalSnapshotBytes[0] / 1048576.0,
+             totalSnapshotBytes[1] / 1048576.0, allSnapshotsDirect ? ", O_DIRECT" : "");
+      printf("Parallel snapshot I/O stall time per process: %.2fms per run, at most %.2fms (%.2fms writing the queue after the run)\n",
+             totalSnapshotTimes[0] * 1000 / numProcs / averageIterations, maxSnapshotTimes[0] * 1000 / averageIterations,
+             totalSnapshotTimes[1] * 1000 / numProcs / averageIterations);
+    }
+    if (haloDepth > 1) {
+      printf("Parallel halo depth: %d (halo messages per process per run: %llu, instead of %d)\n", haloDepth,
+             (unsigned long long)(haloMessages / averageIterations), 2 * generations);
+    }
+    if (init == "counter") {
+      printf("Parallel board hash (initial, final): %016llx, %016llx\n", (unsigned long long)boardHashes[0], (unsigned long long)boardHashes[1]);
+      printf("Parallel final hash per process:");
+      for (int p = 0; p < numProcs; p++) printf(" %016llx", (unsigned long long)processHashes[p]);
+      printf("\n");
+    }
+    if (decomposition == "2d") {
+      printf("Parallel process grid: %d x %d\n", dims[0], dims[1]);
+      printf("Parallel halo cells per process per generation: %d (rows decomposition: %d)\n", maxHaloCells, 2 * (totalColumns + 2));
+    }
+    if (init == "seed") outputFile.close();
+  }
+
+  if (cart != MPI_COMM_NULL) MPI_Comm_free(&cart);
+
   // gracefully exit the mpi environment
   MPI_Finalize();
   return 0;
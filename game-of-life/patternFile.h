@@ -0,0 +1,203 @@
+#ifndef PATTERN_FILE_H
+#define PATTERN_FILE_H
+
+#include <ctype.h>
+#include <stdint.h>
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+/*
+
+Standard Life pattern files:
+  - plaintext (.cells): "!" lines are comments, then one line per row, "." for a dead cell and "O" for a live one
+  - RLE (.rle): "#" lines are comments, then a header "x = <columns>, y = <rows>, rule = B3/S23", then the cells as runs:
+    <count><tag>, where the tag is "b" (dead), "o" (alive), or "$" (end of row), and the pattern ends with "!"
+    * a missing count is 1, dead cells at the end of a row are left out, and the lines are at most 70 characters
+
+Both are streamed: the parser reads one character at a time and hands every live cell straight to the board, and the encoders
+read the board one cell at a time and write whole lines - so a pattern never needs to fit in memory as text.
+
+*/
+
+const int rleLineLength = 70;
+
+inline bool isPlaintextCell(const int c) {
+  return c == '.' || c == 'O' || c == '*';
+}
+
+// skip the rest of a line
+inline void skipLine(std::istream &in) {
+  int c;
+  while ((c = in.get()) != EOF && c != '\n') {
+  }
+}
+
+// read a pattern (RLE or plaintext, told apart by their first characters), calling setCell(row, column) for every live cell
+// (relative to the top left corner of the pattern) - returns false (with an error) if the pattern is malformed
+template <typename SetCell>
+bool readPattern(std::istream &in, SetCell setCell, std::string &error) {
+  // skip the comments and blank lines, and find out which format this is
+  bool plaintext = false;
+  int c;
+  while ((c = in.peek()) != EOF) {
+    if (c == '!') {
+      plaintext = true;
+      skipLine(in);
+    } else if (c == '\n' || c == '\r') {
+      // an empty line is an empty row of a plaintext pattern (after its comments)
+      if (plaintext) break;
+      skipLine(in);
+    } else if (c == '#') {
+      skipLine(in);
+    } else if (c == 'x') {
+      // the RLE header - the body says where each row ends, so the sizes aren't needed
+      skipLine(in);
+      break;
+    } else {
+      plaintext = plaintext || isPlaintextCell(c);
+      break;
+    }
+  }
+
+  int64_t row = 0, column = 0;
+  if (plaintext) {
+    while ((c = in.get()) != EOF) {
+      if (c == '\n') {
+        row++;
+        column = 0;
+      } else if (c == '!' && column == 0) {
+        skipLine(in);
+      } else if (c == 'O' || c == '*') {
+        setCell(row, column++);
+      } else if (c == '.') {
+        column++;
+      } else if (c != '\r' && c != ' ') {
+        error = std::string("unexpected character '") + (char)c + "' in a plaintext pattern";
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int64_t count = 0;
+  while ((c = in.get()) != EOF) {
+    if (isdigit(c)) {
+      count = count * 10 + (c - '0');
+      continue;
+    }
+
+    int64_t run = count == 0 ? 1 : count;
+    count = 0;
+    if (c == 'b' || c == '.') {
+      column += run;
+    } else if (c == '$') {
+      row += run;
+      column = 0;
+    } else if (c == '!') {
+      return true;
+    } else if (isalpha(c)) {
+      // "o", or any other state of a multi-state rule, is alive
+      for (int64_t i = 0; i < run; i++) setCell(row, column++);
+    } else if (c == '#') {
+      skipLine(in);
+    } else if (!isspace(c)) {
+      error = std::string("unexpected character '") + (char)c + "' in an RLE pattern";
+      return false;
+    }
+  }
+
+  error = "the RLE pattern has no end ('!')";
+  return false;
+}
+
+// buffers the runs of an RLE pattern into lines of at most rleLineLength characters
+class RLEWriter {
+ public:
+  explicit RLEWriter(std::ostream &out) : out(out) {
+  }
+
+  void run(const int64_t count, const char tag) {
+    // the ends of rows are held back, so that runs of empty rows are merged, and the empty rows at the end are left out
+    if (tag == '$') {
+      pendingRows += count;
+      return;
+    }
+    if (pendingRows > 0) {
+      emit(pendingRows, '$');
+      pendingRows = 0;
+    }
+    emit(count, tag);
+  }
+
+  void finish() {
+    line += '!';
+    out << line << "\n";
+    line.clear();
+  }
+
+ private:
+  std::ostream &out;
+  std::string line;
+  int64_t pendingRows = 0;
+
+  void emit(const int64_t count, const char tag) {
+    std::string token = count == 1 ? std::string(1, tag) : std::to_string(count) + tag;
+    if (line.size() + token.size() > rleLineLength) {
+      out << line << "\n";
+      line.clear();
+    }
+    line += token;
+  }
+};
+
+// write a board as an RLE pattern, reading it one cell at a time with getCell(row, column)
+template <typename GetCell>
+void writeRLE(std::ostream &out, const int64_t rows, const int64_t columns, GetCell getCell, const std::string &rule = "B3/S23") {
+  out << "x = " << columns << ", y = " << rows << ", rule = " << rule << "\n";
+
+  RLEWriter writer(out);
+  for (int64_t r = 0; r < rows; r++) {
+    int64_t c = 0;
+    while (c < columns) {
+      // the length of the run of cells with the same value
+      bool alive = getCell(r, c);
+      int64_t end = c + 1;
+      while (end < columns && getCell(r, end) == alive) end++;
+
+      // dead cells at the end of a row are implied by the end of the row
+      if (alive || end < columns) writer.run(end - c, alive ? 'o' : 'b');
+      c = end;
+    }
+    writer.run(1, '$');
+  }
+  writer.finish();
+}
+
+// write a board as a plaintext pattern, reading it one cell at a time with getCell(row, column)
+template <typename GetCell>
+void writePlaintext(std::ostream &out, const int64_t rows, const int64_t columns, GetCell getCell) {
+  out << "!Name: game-of-life board\n";
+
+  std::string line(columns, '.');
+  for (int64_t r = 0; r < rows; r++) {
+    for (int64_t c = 0; c < columns; c++) {
+      line[c] = getCell(r, c) ? 'O' : '.';
+    }
+    out << line << "\n";
+  }
+}
+
+// the format to write, from the file name: plaintext for ".cells" and ".txt", RLE otherwise
+inline bool isPlaintextFileName(const std::string &fileName) {
+  const std::string extensions[2] = {".cells", ".txt"};
+  for (const std::string &extension : extensions) {
+    if (fileName.size() >= extension.size() && fileName.compare(fileName.size() - extension.size(), extension.size(), extension) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+#endif
@@ -1,10 +1,10 @@
 
 # make sure we have the correct arguments
-if [ "$#" != 7 ]
+if [ "$#" -lt 7 ] || [ "$#" -gt 10 ]
 then
   echo "We will specify the size of the game board, and provide a random seed that will be used to generate the same board for the serial and parallel versions. We will also need to specify how many generations to run the game for:"
   echo
-  echo "Usage: ${0} <rows> <columns> <seed> <generations> <number of processes> <run serial? [y/n]> <run parallel? [y/n]>"
+  echo "Usage: ${0} <rows> <columns> <seed> <generations> <number of processes> <run serial? [y/n]> <run parallel? [y/n]> <OPTIONAL: run threaded (number of processes = threads)? [y/n]> <OPTIONAL: run hybrid? [y/n]> <OPTIONAL: threads per hybrid process>"
   exit
 fi
 
@@ -16,6 +16,9 @@ generation=$4
 numProcs=$5
 runSerial=$6
 runParallel=$7
+runThreaded=${8:-n}
+runHybrid=${9:-n}
+hybridThreads=${10:-2}
 
 if [ $runParallel == "y" ] && [ $numProcs == "1" ]
 then
@@ -31,6 +34,8 @@ fi
 
 serialFile="serial-output.txt"
 parallelFile="parallel-output.txt"
+threadedFile="threaded-output.txt"
+hybridFile="hybrid-output.txt"
 
 # make the serial and parallel versions
 echo "Making executables"
@@ -72,5 +77,41 @@ then
   fi
 fi
 
+# run the threaded version (one thread per "process"), and compare it to the serial output
+if [ $runThreaded == "y" ]
+then
+  echo "Running threaded"
+  rm -f $threadedFile
+  ./threaded $rows $columns $seed $generation $numProcs
+  echo "Done threaded"
+  echo
+
+  DIFF=$(diff $serialFile $threadedFile)
+  if [ "$DIFF" ]
+  then 
+    echo "The serial and threaded outputs are different!"
+  else
+    echo "The serial and threaded outputs are the same and correct!"
+  fi
+fi
+
+# run the hybrid version (number of processes x threads per process), and compare it to the serial output
+if [ $runHybrid == "y" ]
+then
+  echo "Running hybrid"
+  rm -f $hybridFile
+  mpirun -np $numProcs ./hybrid $rows $columns $seed $generation --threads $hybridThreads
+  echo "Done hybrid"
+  echo
+
+  DIFF=$(diff $serialFile $hybridFile)
+  if [ "$DIFF" ]
+  then 
+    echo "The serial and hybrid outputs are different!"
+  else
+    echo "The serial and hybrid outputs are the same and correct!"
+  fi
+fi
+
 # clean up
 make clean
\ No newline at end of file
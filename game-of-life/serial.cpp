@@ -1,54 +1,83 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <atomic>
 #include <chrono>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <thread>
 #include <vector>
 
-// move cursor so that print over current board
-#define cursup "\033[A"
-#define curshome "\033[0;0H"
-
-// define block to print
-#define BLOCK "\u2593"
-
-// define colours so easier to see movement of live cells
-#define KRED "\x1B[31m"
-#define KGRN "\x1B[32m"
-#define KBLU "\x1B[34m"
-#define KCYN "\x1B[36m"
-#define RESET "\033[0m"
+#include "activeTiles.h"
+#include "bitBoard.h"
+#include "boardFile.h"
+#include "cycleDetector.h"
+#include "ensemble.h"
+#include "largerThanLife.h"
+#include "lifeRule.h"
+#include "outOfCore.h"
+#include "paddedBoard.h"
+#include "patternFile.h"
+#include "snapshotStream.h"
+#include "temporalBlocking.h"
+#include "terminalRenderer.h"
 
 using namespace std;
 
 const string outputFileName = "serial-output.txt";
+const string binaryOutputFileName = "serial-output.bin";
+const string snapshotFileName = "serial-snapshots.gol";
+const string ensembleFileName = "serial-ensemble.txt";
 const int averageIterations = 5;
 
 int totalRows;
 int totalColumns;
 
+// the rule to play (B3/S23 unless --rule is given)
+LifeRule rule;
+
+// the Larger than Life rule to play, for the ltl engine (B3/S23 as a radius 1 rule unless --rule is given in Larger than Life notation)
+LargerThanLifeRule ltlRule;
+bool largerThanLife = false;
+
+// the rule, as it is written in pattern files and printed
+string ruleString() {
+  return largerThanLife ? ltlRule.toString() : rule.toString();
+}
+
+// stop playing whole periods once the board repeats (see cycleDetector.h)
+bool detectCycles = false;
+
+// the cycle found by the last run (period 0 if none was)
+int cyclePeriod = 0;
+int cycleStart = 0;
+int cycleConfirmedAt = 0;
+int cycleSkipped = 0;
+
+// the tiled engine's statistics, over every run
+uint64_t tilesEvaluated = 0;
+uint64_t tilesConsidered = 0;
+
+// the blocked engine's tile and time-block sizes
+int blockTileRows = 0;
+int blockTileColumns = 0;
+int blockSteps = 0;
+
+// stream every snapshotInterval-th generation to the snapshot file, in the background (see snapshotStream.h) - 0 is off
+int snapshotInterval = 0;
+SnapshotStream *snapshots = nullptr;
+
+// should generation be streamed to the snapshot file
+bool snapshotDue(const int generation) {
+  return snapshots != nullptr && generation % snapshotInterval == 0;
+}
+
 // convert a 2d coordinate to a 1d value
 int convertToIndex(const int row, const int column) {
   return row * totalColumns + column;
 }
 
-// print the 2d board
-void printVisualiser(const vector<bool> &board) {
-  printf(curshome);
-  for (int i = 0; i < board.size(); i++) {
-    if (board[i]) {
-      printf(KGRN BLOCK RESET);
-    } else {
-      printf(KRED BLOCK RESET);
-    }
-    if ((i + 1) % totalColumns == 0) {
-      printf("\n");
-    }
-  }
-}
-
 // print the 2d board
 void printBoard(ofstream &file, const vector<bool> &board) {
   for (int i = 0; i < board.size(); i++) {
@@ -61,7 +90,60 @@ void printBoard(ofstream &file, const vector<bool> &board) {
   }
 }
 
-// apply the Game-of-Life rules
+// write the board to a binary board file (see boardFile.h)
+void writeBoardFile(const string &fileName, const vector<bool> &board) {
+  uint8_t header[boardFileHeaderSize];
+  boardFileHeader(totalRows, totalColumns, header);
+
+  vector<uint8_t> bytes;
+  packBoardRows(board, totalRows, totalColumns, bytes);
+
+  ofstream file(fileName, ios::binary);
+  file.write((const char *)header, boardFileHeaderSize);
+  file.write((const char *)bytes.data(), bytes.size());
+}
+
+// place a pattern file on the board, with its top left corner at (atRow, atColumn) - the pattern wraps around the edges
+bool placePattern(const string &fileName, const int atRow, const int atColumn, vector<bool> &board) {
+  ifstream file(fileName);
+  if (!file) {
+    printf("Couldn't open the pattern file: %s\n", fileName.c_str());
+    return false;
+  }
+
+  string error;
+  auto setCell = [&](const int64_t row, const int64_t column) {
+    board[convertToIndex((row + atRow) % totalRows, (column + atColumn) % totalColumns)] = true;
+  };
+  if (!readPattern(file, setCell, error)) {
+    printf("Couldn't read the pattern file %s: %s\n", fileName.c_str(), error.c_str());
+    return false;
+  }
+  return true;
+}
+
+// save the board as a pattern file (plaintext for .cells/.txt, otherwise RLE)
+void savePattern(const string &fileName, const vector<bool> &board) {
+  ofstream file(fileName);
+  auto getCell = [&](const int64_t row, const int64_t column) -> bool { return board[convertToIndex(row, column)]; };
+  if (isPlaintextFileName(fileName)) {
+    writePlaintext(file, totalRows, totalColumns, getCell);
+  } else {
+    writeRLE(file, totalRows, totalColumns, getCell, ruleString());
+  }
+}
+
+// note the cycle found by a run
+template <typename Board>
+void recordCycle(const CycleDetector<Board> &detector) {
+  cyclePeriod = detector.period;
+  cycleStart = detector.cycleStart;
+  cycleConfirmedAt = detector.confirmedAt;
+  cycleSkipped = detector.skipped;
+}
+
+// apply the rules - Rule is a rule mask (see lifeRule.h), or runtimeRule for a rule that is only known at runtime
+template <uint32_t Rule>
 bool cellNextValue(vector<bool> &board, const int row, const int col) {
   // track the number of live neighbours
   int numAlive = 0;
@@ -86,31 +168,296 @@ bool cellNextValue(vector<bool> &board, const int row, const int col) {
     }
   }
 
-  if (board[convertToIndex(row, col)]) {
-    // current cell is ALIVE
+  // B3/S23: a live cell remains alive if there are 2 or 3 live neighbours, and a dead cell will birth a new cell if there are
+  // exactly 3 live neighbours - other rules change those counts
+  return ruleNextValue(Rule == runtimeRule ? rule.mask() : Rule, board[convertToIndex(row, col)], numAlive);
+}
 
-    if (numAlive == 2 || numAlive == 3) {
-      // A live cell remains alive if there are 2 or 3 live neighbours;
-      return true;
-    } else {
-      // A live cell dies if the number of live neighbours is less than 2 (loneliness) or greater than 3 (over-crowding)
-      return false;
+// play the game, one cell at a time
+// (with a renderer attached, a snapshot of every generation is handed to it - the game only waits for the delay, if any)
+template <uint32_t Rule>
+void playNaiveRule(vector<bool> &board, const int generations, TerminalRenderer *renderer, const int delay) {
+  vector<bool> nextGeneration(board.size());
+
+  // the hash of the board (relative to the initial board, see boardFile.h) is updated from the cells that change
+  CycleDetector<vector<bool>> detector(generations, [](const vector<bool> &a, const vector<bool> &b) { return a == b; });
+  uint64_t hash = 0;
+
+  // run the game for a number of iterations
+  for (int iter = 0; iter < generations; iter++) {
+    // determine the next generation of the board
+    for (int row = 0; row < totalRows; row++) {
+      for (int col = 0; col < totalColumns; col++) {
+        // figure out if this cell should be alive/dead
+        nextGeneration[convertToIndex(row, col)] = cellNextValue<Rule>(board, row, col);
+      }
+    }
+
+    // have determined the next generation of the board - make it active
+    if (detectCycles) hash ^= hashCellChanges(board, nextGeneration, board.size(), 0);
+    board.swap(nextGeneration);
+    if (detectCycles) iter += detector.observe(iter + 1, hash, board);
+    if (snapshotDue(iter + 1)) snapshots->recordCells(iter + 1, 0, totalRows, board);
+
+    if (renderer != nullptr) {
+      renderer->publish(board, iter + 1);
+      if (delay > 0) this_thread::sleep_for(chrono::milliseconds(delay));
     }
+  }
+
+  if (detectCycles) recordCycle(detector);
+}
+
+// play the game, one cell at a time - the common rules use their compiled versions
+void playNaive(vector<bool> &board, const int generations, TerminalRenderer *renderer, const int delay) {
+  switch (rule.mask()) {
+    case conwayRule:
+      playNaiveRule<conwayRule>(board, generations, renderer, delay);
+      break;
+    case highLifeRule:
+      playNaiveRule<highLifeRule>(board, generations, renderer, delay);
+      break;
+    case dayAndNightRule:
+      playNaiveRule<dayAndNightRule>(board, generations, renderer, delay);
+      break;
+    case seedsRule:
+      playNaiveRule<seedsRule>(board, generations, renderer, delay);
+      break;
+    default:
+      playNaiveRule<runtimeRule>(board, generations, renderer, delay);
+  }
+}
+
+// play the game on the bit-packed board, 64 cells at a time
+void playBitPacked(vector<bool> &board, const int generations) {
+  BitBoard packed, nextGeneration;
+  packed.resize(totalRows, totalColumns);
+  nextGeneration.resize(totalRows, totalColumns);
+  packed.pack(board);
+
+  CycleDetector<vector<uint64_t>> detector(generations, [](const vector<uint64_t> &a, const vector<uint64_t> &b) { return a == b; });
+  uint64_t hash = 0;
+
+  for (int iter = 0; iter < generations; iter++) {
+    for (int row = 0; row < totalRows; row++) {
+      // wraparound to the other side of the board
+      const uint64_t *above = packed.row((row - 1 + totalRows) % totalRows);
+      const uint64_t *below = packed.row((row + 1) % totalRows);
+      nextRowBits(above, packed.row(row), below, nextGeneration.row(row), packed.wordsPerRow, totalColumns, rule);
+      if (detectCycles) hash ^= hashBitChanges(packed.row(row), nextGeneration.row(row), packed.wordsPerRow, (uint64_t)row * totalColumns);
+    }
+
+    packed.words.swap(nextGeneration.words);
+    if (detectCycles) iter += detector.observe(iter + 1, hash, packed.words);
+    if (snapshotDue(iter + 1)) snapshots->recordBits(iter + 1, 0, totalRows, packed);
+  }
+
+  packed.unpack(board);
+  if (detectCycles) recordCycle(detector);
+}
+
+// play the game on the padded byte board - the halo is filled once per generation, then every row is updated branch-free
+void playPadded(vector<bool> &board, const int generations) {
+  PaddedBoard padded, nextGeneration;
+  padded.resize(totalRows, totalColumns);
+  nextGeneration.resize(totalRows, totalColumns);
+  padded.load(board);
+
+  CycleDetector<PaddedBoard> detector(generations, [](const PaddedBoard &a, const PaddedBoard &b) { return a.sameCells(b); });
+  uint64_t hash = 0;
+
+  for (int iter = 0; iter < generations; iter++) {
+    // wraparound: copy the other side of the board into the halo
+    padded.fillRowHalo();
+    padded.fillColumnHalo();
+
+    for (int row = 0; row < totalRows; row++) {
+      nextRowPadded(padded.row(row - 1), padded.row(row), padded.row(row + 1), nextGeneration.row(row), totalColumns, rule);
+      if (detectCycles) hash ^= hashByteChanges(padded.row(row), nextGeneration.row(row), totalColumns, (uint64_t)row * totalColumns);
+    }
+
+    padded.cells.swap(nextGeneration.cells);
+    if (detectCycles) iter += detector.observe(iter + 1, hash, padded);
+    if (snapshotDue(iter + 1)) snapshots->recordPadded(iter + 1, 0, totalRows, padded);
+  }
+
+  padded.store(board);
+  if (detectCycles) recordCycle(detector);
+}
+
+// play the game on the padded byte board, only evaluating the tiles that (or whose neighbours) changed since two generations ago
+void playTiled(vector<bool> &board, const int generations) {
+  PaddedBoard padded, nextGeneration;
+  padded.resize(totalRows, totalColumns);
+  nextGeneration.resize(totalRows, totalColumns);
+  padded.load(board);
+
+  ActiveTiles tiles;
+  tiles.resize(totalRows, totalColumns);
+  tiles.rule = rule;
+  tiles.hashing = detectCycles;
+
+  CycleDetector<PaddedBoard> detector(generations, [](const PaddedBoard &a, const PaddedBoard &b) { return a.sameCells(b); });
+  uint64_t hash = 0;
+
+  for (int iter = 0; iter < generations; iter++) {
+    // wraparound: copy the other side of the board into the halo
+    padded.fillRowHalo();
+    padded.fillColumnHalo();
+
+    // the tile rows beyond the edges of the board are the ones on the other side
+    tiles.step(padded, nextGeneration, tiles.tileRow(tiles.tileRows - 1), tiles.tileRow(0));
+
+    padded.cells.swap(nextGeneration.cells);
+    if (detectCycles) {
+      hash ^= tiles.hashChange;
+      iter += detector.observe(iter + 1, hash, padded);
+    }
+    if (snapshotDue(iter + 1)) snapshots->recordPadded(iter + 1, 0, totalRows, padded);
+  }
+
+  padded.store(board);
+  if (detectCycles) recordCycle(detector);
+  tilesEvaluated += tiles.evaluated;
+  tilesConsidered += tiles.considered;
+}
+
+// play the game on the padded byte board in cache-sized tiles, several generations per tile at a time (see temporalBlocking.h)
+void playBlocked(vector<bool> &board, const int generations) {
+  PaddedBoard padded, nextGeneration;
+  padded.resize(totalRows, totalColumns);
+  nextGeneration.resize(totalRows, totalColumns);
+  padded.load(board);
+
+  TemporalBlocks blocks;
+  blocks.resize(totalRows, totalColumns);
+  blocks.rule = rule;
+
+  // with snapshots, the board is only whole between snapshots - the time blocks stop at each one
+  for (int iter = 0; iter < generations;) {
+    const int chunk = snapshots != nullptr ? min(snapshotInterval, generations - iter) : generations - iter;
+    blocks.play(padded, nextGeneration, chunk);
+    iter += chunk;
+    if (snapshotDue(iter)) snapshots->recordPadded(iter, 0, totalRows, padded);
+  }
+
+  padded.store(board);
+  blockTileRows = blocks.tileRows;
+  blockTileColumns = blocks.tileColumns;
+  blockSteps = blocks.steps;
+}
+
+// play a Larger than Life rule, with its neighbour counts from running sums (see largerThanLife.h)
+void playLargerThanLife(vector<bool> &board, const int generations) {
+  RadiusBoard current, nextGeneration;
+  current.resize(totalRows, totalColumns, ltlRule.radius);
+  nextGeneration.resize(totalRows, totalColumns, ltlRule.radius);
+  current.load(board);
+
+  LargerThanLife engine;
+  engine.rule = ltlRule;
+
+  CycleDetector<RadiusBoard> detector(generations, [](const RadiusBoard &a, const RadiusBoard &b) { return a.sameCells(b); });
+  uint64_t hash = 0;
+
+  for (int iter = 0; iter < generations; iter++) {
+    // wraparound: copy the other side of the board into the halo rows (the horizontal sums wrap the columns)
+    current.fillRowHalo();
+    engine.step(current, nextGeneration);
+
+    if (detectCycles) {
+      for (int row = 0; row < totalRows; row++) {
+        hash ^= hashByteChanges(current.row(row), nextGeneration.row(row), totalColumns, (uint64_t)row * totalColumns);
+      }
+    }
+
+    current.cells.swap(nextGeneration.cells);
+    if (detectCycles) iter += detector.observe(iter + 1, hash, current);
+    if (snapshotDue(iter + 1)) snapshots->recordPadded(iter + 1, 0, totalRows, current);
+  }
+
+  current.store(board);
+  if (detectCycles) recordCycle(detector);
+}
+
+// print the cell updates per second (n/a if the run was too short to time)
+void printCellUpdateRate(const char *version, const double cellUpdates, const double seconds) {
+  if (seconds > 0) {
+    printf("%s cell updates per second: %.3e\n", version, cellUpdates / seconds);
   } else {
-    // current cell is DEAD
-    if (numAlive == 3) {
-      // A dead cell will birth a new cell if there are exactly 3 live neighbours.
-      return true;
-    } else {
-      return false;
+    printf("%s cell updates per second: n/a\n", version);
+  }
+}
+
+// play an ensemble of boards (one per seed, from firstSeed) on threads threads, which each take the next seed from a shared
+// counter until every board is played (see ensemble.h)
+void playEnsemble(const int firstSeed, const int boards, const int generations, const int threads, vector<BoardSummary> &summaries) {
+  summaries.resize(boards);
+  atomic<int> nextBoard(0);
+
+  auto work = [&]() {
+    EnsembleBoard ensembleBoard;
+    ensembleBoard.rule = rule;
+    ensembleBoard.detectCycles = detectCycles;
+    ensembleBoard.resize(totalRows, totalColumns);
+    for (int board = nextBoard++; board < boards; board = nextBoard++) {
+      summaries[board] = ensembleBoard.play((int64_t)firstSeed + board, generations);
     }
+  };
+
+  // this thread is a worker too
+  vector<thread> workers;
+  for (int t = 1; t < threads; t++) workers.emplace_back(work);
+  work();
+  for (thread &worker : workers) worker.join();
+}
+
+// play the counter-based board of a seed out of core (see outOfCore.h): it's generated into a board file in directory, and each
+// generation streams one board file into the other - the final board is left in directory/serial-output.bin
+// false if the files can't be made
+bool playOutOfCore(const string &directory, const int seed, const int generations, OutOfCoreStrips &strips, uint64_t &population,
+                   double &initialiseTime) {
+  const string fileNames[2] = {directory + "/serial-board-0.bin", directory + "/serial-board-1.bin"};
+  if (!createBoardFile(fileNames[0], totalRows, totalColumns) || !createBoardFile(fileNames[1], totalRows, totalColumns)) return false;
+
+  MappedBoard boards[2];
+  if (!boards[0].map(fileNames[0], totalRows, totalColumns, 0, totalRows) || !boards[1].map(fileNames[1], totalRows, totalColumns, 0, totalRows)) {
+    return false;
+  }
+
+  auto startTime = chrono::high_resolution_clock::now();
+  population = strips.initialise(boards[0], seed);
+  initialiseTime = chrono::duration<double>(chrono::high_resolution_clock::now() - startTime).count();
+
+  // the rows above the first row and below the last (wraparound), copied out before the file they're in is overwritten
+  vector<uint8_t> above(boards[0].rowBytes), below(boards[0].rowBytes);
+  int current = 0;
+  for (int iter = 0; iter < generations; iter++) {
+    memcpy(above.data(), boards[current].row(totalRows - 1), above.size());
+    memcpy(below.data(), boards[current].row(0), below.size());
+    population = strips.play(boards[current], boards[1 - current], above.data(), below.data());
+    current = 1 - current;
   }
+
+  boards[0].unmap();
+  boards[1].unmap();
+  remove(fileNames[1 - current].c_str());
+  return rename(fileNames[current].c_str(), (directory + "/" + binaryOutputFileName).c_str()) == 0;
+}
+
+// print how to run the program
+void printUsage(const char *program) {
+  printf("Usage: %s <rows> <columns> <seed> <generation> <OPTIONAL: visualise> <OPTIONAL: --delay <ms per generation>> <OPTIONAL: --engine [naive/bitpacked/padded/tiled/blocked/ltl]> <OPTIONAL: --init [seed/counter]>\n"
+         "       <OPTIONAL: --pattern <file (rle/plaintext)>> <OPTIONAL: --at <row> <column>> <OPTIONAL: --save <file (.rle/.cells)>>\n"
+         "       <OPTIONAL: --rule <B.../S..., e.g. B36/S23, or Larger than Life for the ltl engine, e.g. R5,C0,M1,S34..58,B34..45,NM>> <OPTIONAL: --detect-cycles> <OPTIONAL: --snapshots <generations between snapshots>>\n"
+         "       <OPTIONAL: --ensemble <boards (one per seed, from the seed)>> <OPTIONAL: --threads <threads, for the ensemble>> <OPTIONAL: --out-of-core <directory for the board files>>\n",
+         program);
 }
 
 int main(int argc, char *argv[]) {
   // check we have the arguments we need
   if (argc < 5) {
-    printf("Usage: %s <rows> <columns> <seed> <generation> <OPTIONAL: visualise>\n", argv[0]);
+    printUsage(argv[0]);
     return 0;
   }
 
@@ -123,56 +470,334 @@ int main(int argc, char *argv[]) {
   int seed = atoi(argv[3]);
   int generation = atoi(argv[4]);
 
-  bool visualise = argc == 6 ? true : false;
+  // optional arguments
+  bool visualise = false;
+  string engine = "naive";
+  string init = "seed";
+  string patternFileName, saveFileName;
+  int atRow = 0, atColumn = 0;
+  int delay = 0;
+  int ensembleBoards = 0;
+  int threads = 1;
+  string outOfCoreDirectory;
+  for (int i = 5; i < argc; i++) {
+    string option(argv[i]);
+    if (option == "--engine" && i + 1 < argc) {
+      engine = argv[++i];
+    } else if (option == "--init" && i + 1 < argc) {
+      init = argv[++i];
+    } else if (option == "--pattern" && i + 1 < argc) {
+      patternFileName = argv[++i];
+    } else if (option == "--at" && i + 2 < argc) {
+      atRow = atoi(argv[++i]);
+      atColumn = atoi(argv[++i]);
+    } else if (option == "--save" && i + 1 < argc) {
+      saveFileName = argv[++i];
+    } else if (option == "--rule" && i + 1 < argc) {
+      largerThanLife = isLargerThanLifeRule(argv[++i]);
+      if (largerThanLife ? !ltlRule.parse(argv[i]) : !rule.parse(argv[i])) {
+        printf("Unknown rule: %s (expected B/S notation, e.g. B3/S23, or Larger than Life, e.g. R5,C0,M1,S34..58,B34..45,NM)\n", argv[i]);
+        return 0;
+      }
+    } else if (option == "--detect-cycles") {
+      detectCycles = true;
+    } else if (option == "--delay" && i + 1 < argc) {
+      delay = atoi(argv[++i]);
+    } else if (option == "--ensemble" && i + 1 < argc) {
+      ensembleBoards = atoi(argv[++i]);
+      if (ensembleBoards <= 0) {
+        printf("The ensemble must have at least 1 board\n");
+        return 0;
+      }
+    } else if (option == "--threads" && i + 1 < argc) {
+      threads = atoi(argv[++i]);
+      if (threads <= 0) {
+        printf("Please choose at least 1 thread\n");
+        return 0;
+      }
+    } else if (option == "--out-of-core" && i + 1 < argc) {
+      outOfCoreDirectory = argv[++i];
+    } else if (option == "--snapshots" && i + 1 < argc) {
+      snapshotInterval = atoi(argv[++i]);
+      if (snapshotInterval <= 0) {
+        printf("The snapshot interval must be at least 1 generation\n");
+        return 0;
+      }
+    } else if (option == "v" || option == "visualise") {
+      visualise = true;
+    } else {
+      // an unknown option, or one without its value
+      printUsage(argv[0]);
+      return 0;
+    }
+  }
+
+  if (engine != "naive" && engine != "bitpacked" && engine != "padded" && engine != "tiled" && engine != "blocked" && engine != "ltl") {
+    printf("Unknown engine: %s\n", engine.c_str());
+    return 0;
+  }
+
+  if (init != "seed" && init != "counter") {
+    printf("Unknown initialisation: %s\n", init.c_str());
+    return 0;
+  }
+
+  if (visualise && engine != "naive") {
+    printf("The visualiser is only available with the naive engine\n");
+    return 0;
+  }
+
+  // the blocked engine plays several generations of a tile at once, so there is no whole board to hash in between
+  if (detectCycles && engine == "blocked") {
+    printf("Cycle detection isn't available with the blocked engine\n");
+    return 0;
+  }
+
+  // cycle detection skips generations, some of which would be snapshots
+  if (detectCycles && snapshotInterval > 0) {
+    printf("Cycle detection isn't available with snapshots\n");
+    return 0;
+  }
+
+  // Larger than Life rules have their own engine (and it only plays them - B3/S23 is a radius 1 rule too)
+  if (largerThanLife != (engine == "ltl") && (largerThanLife || !rule.isConway())) {
+    printf("Larger than Life rules are played by the ltl engine (and only them): add --engine ltl, or give the rule in Larger than Life notation\n");
+    return 0;
+  }
+
+  // a cell can't be in its own neighbourhood twice
+  if (engine == "ltl" && (totalRows < 2 * ltlRule.radius + 1 || totalColumns < 2 * ltlRule.radius + 1)) {
+    printf("Please choose a board of at least %d x %d for a radius of %d\n", 2 * ltlRule.radius + 1, 2 * ltlRule.radius + 1, ltlRule.radius);
+    return 0;
+  }
+  if (engine == "ltl") largerThanLife = true;
+
+  // the ensemble plays each board with the padded engine, from its seed (with the counter-based initialisation), and only
+  // summarises the final boards
+  if (ensembleBoards > 0 && ((engine != "naive" && engine != "padded") || largerThanLife || visualise || !patternFileName.empty() ||
+                             !saveFileName.empty() || snapshotInterval > 0)) {
+    printf("The ensemble plays B/S rules with the padded engine, from the seeds (without the visualiser, patterns or snapshots)\n");
+    return 0;
+  }
+  if (threads > 1 && ensembleBoards == 0) {
+    printf("Threads are only used by the ensemble\n");
+    return 0;
+  }
+
+  if (ensembleBoards > 0) {
+    vector<BoardSummary> summaries;
+    auto startTime = chrono::high_resolution_clock::now();
+    playEnsemble(seed, ensembleBoards, generation, threads, summaries);
+    auto endTime = chrono::high_resolution_clock::now();
+    const double seconds = chrono::duration<double>(endTime - startTime).count();
+
+    ofstream ensembleFile(ensembleFileName);
+    writeEnsembleSummaries(ensembleFile, summaries);
+    EnsembleStatistics statistics(summaries);
+
+    if (!rule.isConway()) {
+      printf("Serial rule: %s\n", rule.toString().c_str());
+    }
+    printf("Serial ensemble: %d boards of %d x %d (seeds %d to %d), %d generations, %d threads\n", ensembleBoards, totalRows, totalColumns, seed,
+           seed + ensembleBoards - 1, generation, threads);
+    printf("Serial ensemble run time: %.2fms\n", seconds * 1000);
+    printf("Serial boards per second: %.2f\n", ensembleBoards / seconds);
+    printCellUpdateRate("Serial", (double)totalRows * totalColumns * generation * ensembleBoards, seconds);
+    printf("Serial ensemble population (min, mean, max): %lld, %.1f, %lld\n", (long long)statistics.minPopulation, statistics.meanPopulation,
+           (long long)statistics.maxPopulation);
+    printf("Serial ensemble hash: %016llx (summaries in %s)\n", (unsigned long long)statistics.hash, ensembleFileName.c_str());
+    if (detectCycles) {
+      int64_t settled = 0;
+      for (auto &period : statistics.periods) settled += period.second;
+      printf("Serial ensemble cycles: %lld of %d boards settled (up to period %d)", (long long)settled, ensembleBoards, defaultMaxPeriod);
+      for (auto &period : statistics.periods) printf(", period %lld: %lld", (long long)period.first, (long long)period.second);
+      printf("\n");
+    }
+    return 0;
+  }
+
+  // an out-of-core board is never in memory: it's the counter-based board of the seed, played by the bit-packed kernel a strip at
+  // a time, and only written out as a board file
+  if (!outOfCoreDirectory.empty() && ((engine != "naive" && engine != "bitpacked") || init != "counter" || largerThanLife || visualise ||
+                                      !patternFileName.empty() || !saveFileName.empty() || detectCycles || snapshotInterval > 0)) {
+    printf("Out-of-core boards are played by the bitpacked engine from --init counter (without the visualiser, patterns, cycle detection or snapshots)\n");
+    return 0;
+  }
+
+  if (!outOfCoreDirectory.empty()) {
+    OutOfCoreStrips strips;
+    strips.rule = rule;
+    strips.resize(totalRows, totalColumns);
+
+    // a single run: the board can be far bigger than memory, so it isn't played averageIterations times
+    uint64_t population = 0;
+    double initialiseTime = 0;
+    auto startTime = chrono::high_resolution_clock::now();
+    if (!playOutOfCore(outOfCoreDirectory, seed, generation, strips, population, initialiseTime)) {
+      printf("Couldn't make the board files in %s\n", outOfCoreDirectory.c_str());
+      return 0;
+    }
+    auto endTime = chrono::high_resolution_clock::now();
+    const double seconds = chrono::duration<double>(endTime - startTime).count() - initialiseTime;
+    const double boardBytes = (double)totalRows * boardFileRowBytes(totalColumns);
+
+    if (!rule.isConway()) {
+      printf("Serial rule: %s\n", rule.toString().c_str());
+    }
+    printf("Serial out-of-core board: %d x %d (%.2f MiB per board file), strips of %d rows (a window of %.2f MiB)\n", totalRows, totalColumns,
+           boardBytes / 1048576.0, strips.stripRows, 3.0 * strips.stripRows * strips.wordsPerRow * 8 / 1048576.0);
+    printf("Serial out-of-core initialisation time: %.2fms\n", initialiseTime * 1000);
+    printf("Serial out-of-core run time: %.2fms\n", seconds * 1000);
+    printCellUpdateRate("Serial", (double)totalRows * totalColumns * generation, seconds);
+    printf("Serial board streaming rate: %.2f MiB/s (read and written)\n", 2 * boardBytes * generation / seconds / 1048576.0);
+    printf("Serial final population: %llu (board in %s/%s)\n", (unsigned long long)population, outOfCoreDirectory.c_str(),
+           binaryOutputFileName.c_str());
+    return 0;
+  }
+
+  // the initial board from a pattern file, placed on an empty board
+  vector<bool> patternBoard;
+  if (!patternFileName.empty()) {
+    if (atRow < 0 || atColumn < 0) {
+      printf("The pattern must be placed at a non-negative row and column\n");
+      return 0;
+    }
+    patternBoard.resize(totalRows * totalColumns);
+    if (!placePattern(patternFileName, atRow, atColumn, patternBoard)) return 0;
+  }
+
+  // the visualiser draws on its own thread, so the game runs at full speed
+  unique_ptr<TerminalRenderer> renderer;
+  if (visualise) {
+    fflush(stdout);
+    renderer.reset(new TerminalRenderer(totalRows, totalColumns));
+    renderer->start();
+  }
 
   u_int64_t runTime = 0;
+  uint64_t initialHash = 0, finalHash = 0;
+
+  // the snapshot statistics, over every run (each run rewrites the snapshot file)
+  uint64_t snapshotCount = 0, snapshotPackedBytes = 0, snapshotWrittenBytes = 0;
+  double snapshotStallTime = 0, snapshotDrainTime = 0;
+  bool snapshotsDirect = false;
 
   for (int _ = 0; _ < averageIterations; _++) {
     // create our board
-    vector<bool> board, nextGeneration;
+    vector<bool> board;
     board.resize(totalRows * totalColumns);
-    nextGeneration.resize(totalRows * totalColumns);
 
     // initialise the board using the seed
-    srand(seed);
-    for (int i = 0; i < board.size(); i++) {
-      bool value = ((double)rand() / RAND_MAX) >= 0.5 ? true : false;
-      board[i] = value;
+    if (!patternFileName.empty()) {
+      board = patternBoard;
+    } else if (init == "counter") {
+      // the same board as the parallel version's distributed initialisation
+      for (int i = 0; i < board.size(); i++) {
+        board[i] = counterCell(seed, i);
+      }
+    } else {
+      srand(seed);
+      for (int i = 0; i < board.size(); i++) {
+        bool value = ((double)rand() / RAND_MAX) >= 0.5 ? true : false;
+        board[i] = value;
+      }
     }
+    initialHash = hashCells(board, board.size(), 0);
 
     // print the initial board
     outputFile << "\n";
     printBoard(outputFile, board);
 
+    unique_ptr<SnapshotStream> stream;
+    if (snapshotInterval > 0) {
+      stream.reset(new SnapshotStream(snapshotFileName, totalColumns));
+      snapshots = stream.get();
+    }
+
     auto startTime = chrono::high_resolution_clock::now();
+    if (snapshots != nullptr) snapshots->recordCells(0, 0, totalRows, board);
     // run the game for a number of iterations
-    for (int iter = 0; iter < generation; iter++) {
-      // determine the next generation of the board
-      for (int row = 0; row < totalRows; row++) {
-        for (int col = 0; col < totalColumns; col++) {
-          // figure out if this cell should be alive/dead
-          nextGeneration[convertToIndex(row, col)] = cellNextValue(board, row, col);
-        }
-      }
-
-      // have determined the next generation of the board - make it active
-      board.swap(nextGeneration);
-
-      if (visualise) {
-        printVisualiser(board);
-        this_thread::sleep_for(chrono::milliseconds(500));
-      }
+    if (engine == "bitpacked") {
+      playBitPacked(board, generation);
+    } else if (engine == "padded") {
+      playPadded(board, generation);
+    } else if (engine == "tiled") {
+      playTiled(board, generation);
+    } else if (engine == "blocked") {
+      playBlocked(board, generation);
+    } else if (engine == "ltl") {
+      playLargerThanLife(board, generation);
+    } else {
+      if (renderer) renderer->publish(board, 0);
+      playNaive(board, generation, renderer.get(), delay);
     }
     auto endTime = chrono::high_resolution_clock::now();
-    auto duration = chrono::duration_cast<chrono::milliseconds>(endTime - startTime);
+    auto duration = chrono::duration_cast<chrono::microseconds>(endTime - startTime);
     runTime += duration.count();
 
+    // the snapshots still queued are written after the run (the time it takes is how far the writer fell behind)
+    if (stream) {
+      auto drainStart = chrono::high_resolution_clock::now();
+      stream->close();
+      snapshotDrainTime += chrono::duration<double>(chrono::high_resolution_clock::now() - drainStart).count();
+      if (!stream->good()) {
+        printf("Couldn't write the snapshots to %s\n", snapshotFileName.c_str());
+        return 0;
+      }
+      snapshotCount = stream->snapshots;
+      snapshotPackedBytes = stream->packedBytes;
+      snapshotWrittenBytes = stream->writtenBytes;
+      snapshotStallTime += stream->stallTime;
+      snapshotsDirect = stream->direct;
+      snapshots = nullptr;
+    }
+
     // print the final board
     outputFile << "\n";
     printBoard(outputFile, board);
+    finalHash = hashCells(board, board.size(), 0);
+
+    if (init == "counter" && _ == averageIterations - 1) {
+      writeBoardFile(binaryOutputFileName, board);
+    }
+    if (!saveFileName.empty() && _ == averageIterations - 1) {
+      savePattern(saveFileName, board);
+    }
   }
 
-  printf("Serial average run time: %.2fms\n", (double)runTime / averageIterations);
+  if (renderer) {
+    renderer->stop();
+    printf("Serial frames drawn: %llu of %llu (%llu dropped)\n", (unsigned long long)renderer->framesDrawn,
+           (unsigned long long)renderer->framesPublished, (unsigned long long)(renderer->framesPublished - renderer->framesDrawn));
+  }
+  if (largerThanLife || !rule.isConway()) {
+    printf("Serial rule: %s\n", ruleString().c_str());
+  }
+  printf("Serial average run time: %.2fms\n", (double)runTime / 1000 / averageIterations);
+  printCellUpdateRate("Serial", (double)totalRows * totalColumns * generation, (double)runTime / averageIterations / 1000000);
+  if (init == "counter") {
+    printf("Serial board hash (initial, final): %016llx, %016llx\n", (unsigned long long)initialHash, (unsigned long long)finalHash);
+  }
+  if (detectCycles && cyclePeriod > 0) {
+    printf("Serial cycle: period %d from generation %d (confirmed at generation %d, %d generations skipped)\n", cyclePeriod, cycleStart,
+           cycleConfirmedAt, cycleSkipped);
+  } else if (detectCycles) {
+    printf("Serial cycle: none found (up to period %d)\n", defaultMaxPeriod);
+  }
+  if (engine == "blocked") {
+    printf("Serial temporal blocking: %d x %d cell tiles, %d generations per tile at a time (L2 cache: %zu KiB)\n", blockTileRows, blockTileColumns,
+           blockSteps, cacheSize() / 1024);
+  }
+  if (snapshotInterval > 0) {
+    printf("Serial snapshots: every %d generations, %llu per run to %s (%.2f MiB packed, %.2f MiB written%s)\n", snapshotInterval,
+           (unsigned long long)snapshotCount, snapshotFileName.c_str(), snapshotPackedBytes / 1048576.0, snapshotWrittenBytes / 1048576.0,
+           snapshotsDirect ? ", O_DIRECT" : "");
+    printf("Serial snapshot I/O stall time: %.2fms per run (%.2fms writing the queue after the run)\n", snapshotStallTime * 1000 / averageIterations,
+           snapshotDrainTime * 1000 / averageIterations);
+  }
+  if (engine == "tiled") {
+    printf("Serial tiles evaluated per generation: %.2f%%\n", tilesConsidered == 0 ? 0.0 : 100.0 * tilesEvaluated / tilesConsidered);
+  }
 
   // close the file
   outputFile.close();
@@ -0,0 +1,339 @@
+#ifndef SNAPSHOT_STREAM_H
+#define SNAPSHOT_STREAM_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "boardFile.h"
+
+/*
+
+Snapshot streaming (every k-th generation, written in the background):
+  - the game only packs its rows to bits (1 bit per cell, as in a board file - see boardFile.h) into a free slot of a bounded
+    queue, and carries on - a writer thread does the rest
+    * the queue has a fixed number of slots, so the game only waits for the disk when every slot is full (the time it waits is
+      the I/O stall time)
+  - the writer XORs each snapshot with the last one (a settled board barely changes, so the delta is almost all zeros), and
+    run-length encodes it (PackBits: a header byte h, then h + 1 literal bytes if h < 128, or one byte repeated h - 125 times)
+    * every keyframeInterval-th snapshot (and the first, and any whose rows moved) is the whole board instead of a delta, so a
+      reader can start there
+  - the file is written with O_DIRECT (where the file system supports it), so the snapshots go straight to the disk instead of
+    filling the page cache: the records are gathered in an aligned buffer and written in whole blocks, and the file is cut back
+    to its real size at the end
+  - the file is the magic "GOLSNAPS", then a record per snapshot: a 48 byte header (the generation, first row, rows and columns,
+    whether it is a delta, and the size of the encoded rows, as 64-bit integers), then the encoded rows
+    * each record says which rows it holds, so every MPI process streams its own rows to its own file
+
+*/
+
+const char snapshotFileMagic[8] = {'G', 'O', 'L', 'S', 'N', 'A', 'P', 'S'};
+const int snapshotRecordHeaderSize = 48;
+const int defaultSnapshotSlots = 8;
+const int keyframeInterval = 16;
+const size_t snapshotBlockSize = 4096;            // the alignment O_DIRECT needs
+const size_t snapshotBufferSize = 256 * snapshotBlockSize;
+
+// pack a row of 0/1 bytes into bits (bit j of byte b is column 8b + j) - 8 cells at a time, with a multiply
+inline void packByteRow(const uint8_t *cells, const int columns, uint8_t *bits) {
+  int c = 0;
+  for (; c + 8 <= columns; c += 8) {
+    uint64_t word;
+    memcpy(&word, cells + c, 8);
+    bits[c / 8] = (word * 0x0102040810204080ULL) >> 56;
+  }
+  if (c < columns) {
+    uint8_t last = 0;
+    for (int j = 0; c + j < columns; j++) last |= (cells[c + j] & 1) << j;
+    bits[c / 8] = last;
+  }
+}
+
+// run-length encode bytes (PackBits), appending them to out
+inline void packRuns(const uint8_t *bytes, const size_t count, std::vector<uint8_t> &out) {
+  size_t i = 0;
+  while (i < count) {
+    // a run of at least 3 of the same byte
+    size_t run = 1;
+    while (i + run < count && run < 130 && bytes[i + run] == bytes[i]) run++;
+    if (run >= 3) {
+      out.push_back(run + 125);
+      out.push_back(bytes[i]);
+      i += run;
+      continue;
+    }
+
+    // literals, up to the next run of 3
+    size_t literals = 0;
+    while (i + literals < count && literals < 128) {
+      const size_t j = i + literals;
+      if (j + 2 < count && bytes[j] == bytes[j + 1] && bytes[j] == bytes[j + 2]) break;
+      literals++;
+    }
+    out.push_back(literals - 1);
+    out.insert(out.end(), bytes + i, bytes + i + literals);
+    i += literals;
+  }
+}
+
+// the reverse of packRuns (for readers of snapshot files) - returns false if the runs are malformed
+inline bool unpackRuns(const uint8_t *runs, const size_t count, std::vector<uint8_t> &bytes) {
+  bytes.clear();
+  size_t i = 0;
+  while (i < count) {
+    const uint8_t header = runs[i++];
+    if (header < 128) {
+      if (i + header + 1 > count) return false;
+      bytes.insert(bytes.end(), runs + i, runs + i + header + 1);
+      i += header + 1;
+    } else {
+      if (i >= count) return false;
+      bytes.insert(bytes.end(), header - 125, runs[i++]);
+    }
+  }
+  return true;
+}
+
+class SnapshotStream {
+ public:
+  // statistics
+  uint64_t snapshots = 0;
+  uint64_t packedBytes = 0;    // the rows, packed to bits
+  uint64_t writtenBytes = 0;   // the records, after the deltas and run-length encoding
+  double stallTime = 0;        // seconds the game waited for a free slot
+  bool direct = false;         // whether the file is written with O_DIRECT
+
+  // start streaming the rows of a board to a file (created, or truncated)
+  SnapshotStream(const std::string &fileName, const int columns, const int queueSlots = defaultSnapshotSlots) : columns(columns), slots(queueSlots) {
+    for (int s = 0; s < queueSlots; s++) freeSlots.push_back(s);
+    rowBytes = boardFileRowBytes(columns);
+
+#ifdef O_DIRECT
+    file = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    direct = file >= 0;
+#endif
+    if (file < 0) file = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    if (posix_memalign((void **)&buffer, snapshotBlockSize, snapshotBufferSize) != 0) buffer = nullptr;
+    append((const uint8_t *)snapshotFileMagic, sizeof(snapshotFileMagic));
+
+    writer = std::thread(&SnapshotStream::run, this);
+  }
+
+  ~SnapshotStream() {
+    close();
+    free(buffer);
+  }
+
+  // write the snapshots that are still queued, and close the file (the statistics are final after this)
+  void close() {
+    if (!writer.joinable()) return;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    queued.notify_one();
+    writer.join();
+
+    // the last partial block is written whole (O_DIRECT), and the file cut back to its real size
+    if (file >= 0) {
+      if (buffered > 0) {
+        const size_t blockBytes = (buffered + snapshotBlockSize - 1) / snapshotBlockSize * snapshotBlockSize;
+        memset(buffer + buffered, 0, blockBytes - buffered);
+        writeAll(buffer, blockBytes);
+      }
+      if (ftruncate(file, fileBytes) != 0) ok = false;
+      ::close(file);
+    }
+  }
+
+  // did the file open, and every write succeed (only meaningful once the stream is closed)
+  bool good() const {
+    return file >= 0 && buffer != nullptr && ok;
+  }
+
+  // record rows [firstRow, firstRow + rows) of generation generation - packRow(r, bits) packs row r (from firstRow) to bits
+  // only waits if every slot of the queue is full
+  template <typename PackRow>
+  void record(const int64_t generation, const int64_t firstRow, const int rows, PackRow packRow) {
+    int s;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      if (freeSlots.empty()) {
+        auto waitStart = std::chrono::steady_clock::now();
+        slotFreed.wait(lock, [this] { return !freeSlots.empty(); });
+        stallTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - waitStart).count();
+      }
+      s = freeSlots.front();
+      freeSlots.pop_front();
+    }
+
+    Slot &slot = slots[s];
+    slot.generation = generation;
+    slot.firstRow = firstRow;
+    slot.rows = rows;
+    slot.bits.resize((size_t)rows * rowBytes);
+    for (int r = 0; r < rows; r++) packRow(r, slot.bits.data() + (size_t)r * rowBytes);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ready.push_back(s);
+    }
+    queued.notify_one();
+  }
+
+  // the rows of a padded board (see paddedBoard.h) - row(r) is the first cell of row r
+  template <typename Board>
+  void recordPadded(const int64_t generation, const int64_t firstRow, const int rows, const Board &board) {
+    record(generation, firstRow, rows, [&](const int r, uint8_t *bits) { packByteRow(board.row(r), columns, bits); });
+  }
+
+  // the rows of a bit-packed board (see bitBoard.h) - its words are already bits, in the same order
+  template <typename Board>
+  void recordBits(const int64_t generation, const int64_t firstRow, const int rows, const Board &board) {
+    record(generation, firstRow, rows, [&](const int r, uint8_t *bits) {
+      memcpy(bits, board.row(r), rowBytes);
+      if (columns % 8 != 0) bits[rowBytes - 1] &= (1 << (columns % 8)) - 1;
+    });
+  }
+
+  // the rows of a board of 0/1 cells, stored row by row
+  template <typename Cells>
+  void recordCells(const int64_t generation, const int64_t firstRow, const int rows, const Cells &cells) {
+    record(generation, firstRow, rows, [&](const int r, uint8_t *bits) {
+      memset(bits, 0, rowBytes);
+      for (int c = 0; c < columns; c++) {
+        if (cells[(size_t)r * columns + c]) bits[c / 8] |= 1 << (c % 8);
+      }
+    });
+  }
+
+ private:
+  struct Slot {
+    int64_t generation = 0;
+    int64_t firstRow = 0;
+    int rows = 0;
+    std::vector<uint8_t> bits;
+  };
+
+  const int columns;
+  size_t rowBytes = 0;
+
+  // the queue: slots the game can fill, and slots the writer can write (both in order)
+  std::vector<Slot> slots;
+  std::deque<int> freeSlots;
+  std::deque<int> ready;
+  std::mutex mutex;
+  std::condition_variable queued;
+  std::condition_variable slotFreed;
+  bool stopping = false;
+  std::thread writer;
+
+  // owned by the writer
+  int file = -1;
+  uint8_t *buffer = nullptr;  // aligned, for O_DIRECT
+  size_t buffered = 0;
+  uint64_t fileBytes = 0;
+  bool ok = true;
+  std::vector<uint8_t> previous;  // the last snapshot's bits
+  int64_t previousFirstRow = -1;
+  int previousRows = -1;
+  std::vector<uint8_t> delta, encoded;
+
+  void run() {
+    while (true) {
+      int s;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        queued.wait(lock, [this] { return stopping || !ready.empty(); });
+        if (ready.empty()) return;
+        s = ready.front();
+        ready.pop_front();
+      }
+
+      encode(slots[s]);
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        freeSlots.push_back(s);
+      }
+      slotFreed.notify_one();
+    }
+  }
+
+  // write a snapshot as a record: the delta from the last snapshot (or the whole board), run-length encoded
+  void encode(Slot &slot) {
+    const bool keyframe = snapshots % keyframeInterval == 0 || slot.firstRow != previousFirstRow || slot.rows != previousRows;
+    const std::vector<uint8_t> *source = &slot.bits;
+    if (!keyframe) {
+      delta.resize(slot.bits.size());
+      for (size_t i = 0; i < delta.size(); i++) delta[i] = slot.bits[i] ^ previous[i];
+      source = &delta;
+    }
+
+    encoded.assign(snapshotRecordHeaderSize, 0);
+    packRuns(source->data(), source->size(), encoded);
+    const int64_t header[6] = {slot.generation, slot.firstRow, slot.rows, columns, keyframe ? 0 : 1, (int64_t)(encoded.size() - snapshotRecordHeaderSize)};
+    memcpy(encoded.data(), header, snapshotRecordHeaderSize);
+    append(encoded.data(), encoded.size());
+
+    snapshots++;
+    packedBytes += slot.bits.size();
+    writtenBytes += encoded.size();
+    previous.swap(slot.bits);
+    previousFirstRow = slot.firstRow;
+    previousRows = slot.rows;
+  }
+
+  // add bytes to the file, writing each block of the buffer as it fills
+  void append(const uint8_t *bytes, size_t count) {
+    if (buffer == nullptr || file < 0) return;
+    fileBytes += count;
+    while (count > 0) {
+      const size_t length = std::min(count, snapshotBufferSize - buffered);
+      memcpy(buffer + buffered, bytes, length);
+      buffered += length;
+      bytes += length;
+      count -= length;
+      if (buffered == snapshotBufferSize) {
+        writeAll(buffer, buffered);
+        buffered = 0;
+      }
+    }
+  }
+
+  void writeAll(const uint8_t *bytes, size_t count) {
+    while (count > 0) {
+      ssize_t written = write(file, bytes, count);
+      if (written < 0 && errno == EINTR) continue;
+#ifdef O_DIRECT
+      // a file system can take O_DIRECT at open, and refuse it on write
+      if (written < 0 && errno == EINVAL && direct) {
+        fcntl(file, F_SETFL, fcntl(file, F_GETFL) & ~O_DIRECT);
+        direct = false;
+        continue;
+      }
+#endif
+      if (written <= 0) {
+        ok = false;
+        return;
+      }
+      bytes += written;
+      count -= written;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef TEMPORAL_BLOCKING_H
+#define TEMPORAL_BLOCKING_H
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "lifeRule.h"
+#include "paddedBoard.h"
+
+/*
+
+Temporal blocking (multi-generation tiling, on top of the padded byte board):
+  - a generation of the padded engine streams the whole board in and the next generation out - once the board is bigger than
+    the cache, every generation is a round trip to memory, and the kernel waits on it
+  - instead, the board is split into tiles that fit in the cache, and each tile is played several generations (a time block)
+    before moving on to the next one
+  - a tile is copied into a scratch board with "steps" extra rows and columns on every side (overlapped halos, taken from the
+    other side of the board at the edges): each generation, the outermost ring of the scratch board goes stale (its neighbours
+    aren't there), so the region that is updated shrinks by one cell on every side - a trapezoid in time - and after "steps"
+    generations exactly the tile is left, and is copied into the next board
+  - the board is read and written once per time block instead of once per generation, at the cost of recomputing the halo
+    cells of neighbouring tiles (they overlap by 2 * steps)
+  - the tile and time-block sizes are chosen from the size of the L2 cache: the two scratch boards fill half of it (the other
+    half is for the rows streaming in and out), and the time block is a sixteenth of the side of the scratch board, which keeps
+    the recomputed cells to ~15% of the tile
+
+*/
+
+const size_t defaultCacheSize = 256 * 1024;
+
+// the kernel's vector width - the updates are rounded up to whole vectors (the cells past the shrinking region are stale anyway),
+// so no row falls back to the scalar kernel for its last few cells
+const int blockVectorWidth = 32;
+
+// the size of the L2 cache, in bytes (or a guess, if the system doesn't say)
+inline size_t cacheSize() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  long size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (size > 0) return size;
+#endif
+  return defaultCacheSize;
+}
+
+class TemporalBlocks {
+ public:
+  int rows = 0;
+  int columns = 0;
+  int tileRows = 0;     // the cells of a tile (the last tile row/column can be smaller)
+  int tileColumns = 0;
+  int steps = 0;        // the generations played per time block
+  LifeRule rule;
+
+  // choose the tile and time-block sizes for a board that fit a cache of cacheBytes
+  void resize(const int numRows, const int numColumns, const size_t cacheBytes = cacheSize()) {
+    rows = numRows;
+    columns = numColumns;
+
+    // two square scratch boards in half of the cache
+    const int side = std::max(16, (int)std::sqrt((double)cacheBytes / 4));
+    steps = std::max(1, side / 16);
+    tileColumns = std::max(1, std::min(columns, side - 2 * steps - 2));
+
+    // a narrow board leaves room for more rows
+    const int scratchRows = cacheBytes / 4 / (tileColumns + 2 * steps + 2);
+    tileRows = std::max(1, std::min(rows, scratchRows - 2 * steps - 2));
+
+    scratch[0].resize(tileRows + 2 * steps, tileColumns + 2 * steps + blockVectorWidth);
+    scratch[1].resize(tileRows + 2 * steps, tileColumns + 2 * steps + blockVectorWidth);
+  }
+
+  // play generations generations of the board (only the interior of the padded boards is used - the wraparound comes from the
+  // overlapped halos), with nextGeneration as the second buffer
+  void play(PaddedBoard &board, PaddedBoard &nextGeneration, const int generations) {
+    for (int generation = 0; generation < generations; generation += steps) {
+      const int blockSteps = std::min(steps, generations - generation);
+
+      for (int firstRow = 0; firstRow < rows; firstRow += tileRows) {
+        for (int firstColumn = 0; firstColumn < columns; firstColumn += tileColumns) {
+          playTile(board, nextGeneration, firstRow, firstColumn, blockSteps);
+        }
+      }
+
+      board.cells.swap(nextGeneration.cells);
+    }
+  }
+
+ private:
+  PaddedBoard scratch[2];
+
+  // copy count cells of a row of the board, starting from column first (which wraps around the board), to destination
+  void copyWrapped(const uint8_t *source, int first, int count, uint8_t *destination) const {
+    first = ((first % columns) + columns) % columns;
+    while (count > 0) {
+      const int length = std::min(count, columns - first);
+      memcpy(destination, source + first, length);
+      destination += length;
+      count -= length;
+      first = 0;
+    }
+  }
+
+  // play the tile at (firstRow, firstColumn) blockSteps generations, from board into nextGeneration
+  void playTile(const PaddedBoard &board, PaddedBoard &nextGeneration, const int firstRow, const int firstColumn, const int blockSteps) {
+    const int height = std::min(tileRows, rows - firstRow);
+    const int width = std::min(tileColumns, columns - firstColumn);
+    const int scratchRows = height + 2 * blockSteps;
+    const int scratchColumns = width + 2 * blockSteps;
+
+    // the tile, with blockSteps cells of halo on every side
+    PaddedBoard *current = &scratch[0], *next = &scratch[1];
+    for (int r = 0; r < scratchRows; r++) {
+      const int boardRow = (((firstRow - blockSteps + r) % rows) + rows) % rows;
+      copyWrapped(board.row(boardRow), firstColumn - blockSteps, scratchColumns, current->row(r));
+    }
+
+    // after step s, only the cells at least s + 1 from the edge of the scratch board are right
+    for (int s = 0; s < blockSteps; s++) {
+      const int edge = s + 1;
+      const int updateColumns = (scratchColumns - 2 * edge + blockVectorWidth - 1) / blockVectorWidth * blockVectorWidth;
+      for (int r = edge; r < scratchRows - edge; r++) {
+        nextRowPadded(current->row(r - 1) + edge, current->row(r) + edge, current->row(r + 1) + edge, next->row(r) + edge, updateColumns, rule);
+      }
+      std::swap(current, next);
+    }
+
+    for (int r = 0; r < height; r++) {
+      memcpy(nextGeneration.row(firstRow + r) + firstColumn, current->row(blockSteps + r) + blockSteps, width);
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,180 @@
+#ifndef TERMINAL_RENDERER_H
+#define TERMINAL_RENDERER_H
+
+#include <stdint.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// move cursor so that print over current board
+#define cursup "\033[A"
+#define curshome "\033[0;0H"
+#define clearscreen "\033[2J"
+
+// define block to print
+#define BLOCK "\u2593"
+
+// define colours so easier to see movement of live cells
+#define KRED "\x1B[31m"
+#define KGRN "\x1B[32m"
+#define KBLU "\x1B[34m"
+#define KCYN "\x1B[36m"
+#define RESET "\033[0m"
+
+/*
+
+Asynchronous terminal renderer (for the visualiser):
+  - the game publishes a snapshot of the board after every generation, and a renderer thread draws them - so the game
+    never waits for the terminal
+  - the snapshots go through a lock-free triple buffer: the game writes into its own slot, then swaps it with the
+    "latest" slot (one atomic exchange); the renderer swaps the latest slot with its own when a new snapshot is there
+    * neither side ever waits for the other, and the renderer always draws the newest snapshot - any snapshots published
+      in between are dropped frames
+  - a frame only redraws the cells that changed since the last frame drawn (a cursor move per run of changed cells), and
+    the whole frame is one write to the terminal
+  - at most one frame is drawn per frame period, and the last snapshot is always drawn before the renderer stops
+
+*/
+
+const int defaultFramePeriod = 33;  // milliseconds (~30 frames per second)
+
+class TerminalRenderer {
+ public:
+  // statistics
+  uint64_t framesPublished = 0;
+  uint64_t framesDrawn = 0;
+
+  TerminalRenderer(const int rows, const int columns, const int framePeriod = defaultFramePeriod)
+      : rows(rows), columns(columns), framePeriod(framePeriod) {
+    for (Snapshot &slot : slots) slot.cells.assign((size_t)rows * columns, 0);
+    shown.assign((size_t)rows * columns, 0);
+  }
+
+  ~TerminalRenderer() {
+    stop();
+  }
+
+  void start() {
+    if (renderer.joinable()) return;
+    stopping = false;
+    firstFrame = true;
+    renderer = std::thread(&TerminalRenderer::run, this);
+  }
+
+  // draw the last snapshot, and wait for the renderer to finish
+  void stop() {
+    if (!renderer.joinable()) return;
+    stopping = true;
+    renderer.join();
+  }
+
+  // publish a snapshot of a board of 0/1 cells (stored row by row) - never blocks
+  template <typename Cells>
+  void publish(const Cells &board, const int generation) {
+    Snapshot &slot = slots[writeSlot];
+    for (size_t i = 0; i < slot.cells.size(); i++) {
+      slot.cells[i] = board[i] ? 1 : 0;
+    }
+    slot.generation = generation;
+
+    // hand the slot over as the latest snapshot, and take back the one it replaces
+    writeSlot = latest.exchange(writeSlot | freshFlag, std::memory_order_acq_rel) & slotMask;
+    framesPublished++;
+  }
+
+ private:
+  struct Snapshot {
+    std::vector<uint8_t> cells;
+    int generation = 0;
+  };
+
+  static const int freshFlag = 4;  // set on the latest slot when it holds a snapshot the renderer hasn't taken yet
+  static const int slotMask = 3;
+
+  const int rows;
+  const int columns;
+  const int framePeriod;
+
+  Snapshot slots[3];
+  int writeSlot = 0;           // owned by the game
+  int readSlot = 1;            // owned by the renderer
+  std::atomic<int> latest{2};  // shared
+  std::atomic<bool> stopping{false};
+
+  std::vector<uint8_t> shown;  // what the terminal shows
+  bool firstFrame = true;
+  std::string frame;
+  std::thread renderer;
+
+  // take the latest snapshot, if there is a new one
+  bool takeLatest() {
+    if (!(latest.load(std::memory_order_acquire) & freshFlag)) return false;
+    readSlot = latest.exchange(readSlot, std::memory_order_acq_rel) & slotMask;
+    return true;
+  }
+
+  void run() {
+    while (true) {
+      auto frameStart = std::chrono::steady_clock::now();
+      bool finishing = stopping.load();
+      if (takeLatest()) draw(slots[readSlot]);
+      if (finishing) break;
+      std::this_thread::sleep_until(frameStart + std::chrono::milliseconds(framePeriod));
+    }
+  }
+
+  void moveTo(const int row, const int column) {
+    frame += "\033[" + std::to_string(row + 1) + ";" + std::to_string(column + 1) + "H";
+  }
+
+  void draw(const Snapshot &snapshot) {
+    frame.clear();
+    if (firstFrame) frame += clearscreen;
+
+    for (int r = 0; r < rows; r++) {
+      const uint8_t *cells = snapshot.cells.data() + (size_t)r * columns;
+      uint8_t *shownCells = shown.data() + (size_t)r * columns;
+
+      int c = 0;
+      while (c < columns) {
+        if (!firstFrame && cells[c] == shownCells[c]) {
+          c++;
+          continue;
+        }
+
+        // a run of changed cells: one cursor move, then a colour code whenever the colour changes
+        moveTo(r, c);
+        int colour = -1;
+        while (c < columns && (firstFrame || cells[c] != shownCells[c])) {
+          if (cells[c] != colour) {
+            colour = cells[c];
+            frame += colour ? KGRN : KRED;
+          }
+          frame += BLOCK;
+          shownCells[c] = cells[c];
+          c++;
+        }
+        frame += RESET;
+      }
+    }
+
+    moveTo(rows, 0);
+    frame += "generation " + std::to_string(snapshot.generation) + "\033[K\n";
+    firstFrame = false;
+    framesDrawn++;
+
+    // the whole frame in one write
+    size_t written = 0;
+    while (written < frame.size()) {
+      ssize_t count = write(STDOUT_FILENO, frame.data() + written, frame.size() - written);
+      if (count <= 0) break;
+      written += count;
+    }
+  }
+};
+
+#endif
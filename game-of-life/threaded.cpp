@@ -0,0 +1,267 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "paddedBoard.h"
+
+using namespace std;
+
+/*
+
+General Idea (shared memory, one process):
+  - the board is a padded byte board (see paddedBoard.h), split into cache-sized tiles, with two buffers (generation g is in buffer g % 2)
+  - each tile counts the generations it has completed; a tile can compute generation g + 1 once its 8 (wrapped) neighbours
+    have completed generation g:
+    * they have written generation g, which it reads
+    * they have finished reading generation g - 1, which it overwrites
+    so there is no barrier between generations - tiles only wait on their neighbours, and neighbouring tiles are never more
+    than one generation apart
+  - the tile on an edge of the board writes the wraparound halo cells for its own cells, so the halo is also only read by
+    the neighbours that wait on it
+  - scheduling is work-stealing: each thread has a deque of tiles (a contiguous block, for locality), takes its next ready
+    tile from the back, and when none of its own tiles are ready, steals one from the front of another thread's deque
+
+*/
+
+const string outputFileName = "threaded-output.txt";
+const int averageIterations = 5;
+
+// ~8KB of cells per tile and buffer
+const int tileHeight = 32;
+const int tileWidth = 256;
+
+int totalRows;
+int totalColumns;
+
+// print the 2d board
+void printBoard(ofstream &file, const vector<bool> &board) {
+  for (int i = 0; i < board.size(); i++) {
+    file << board[i];
+    if ((i + 1) % totalColumns == 0) {
+      file << "\n";
+    }
+  }
+}
+
+// a thread's tiles - the owner works from the back, thieves steal from the front
+typedef struct {
+  mutex lock;
+  deque<int> tiles;
+} work_queue;
+
+class ThreadedGame {
+ public:
+  uint64_t steals = 0;
+
+  ThreadedGame(const int numThreads) : numThreads(numThreads) {
+    tileRows = (totalRows + tileHeight - 1) / tileHeight;
+    tileColumns = (totalColumns + tileWidth - 1) / tileWidth;
+    numTiles = tileRows * tileColumns;
+
+    // the 8 wrapped neighbours of each tile
+    neighbours.resize(numTiles);
+    for (int tr = 0; tr < tileRows; tr++) {
+      for (int tc = 0; tc < tileColumns; tc++) {
+        for (int i = -1; i <= 1; i++) {
+          for (int j = -1; j <= 1; j++) {
+            if (i == 0 && j == 0) continue;
+            int neighbour = ((tr + i + tileRows) % tileRows) * tileColumns + (tc + j + tileColumns) % tileColumns;
+            neighbours[tr * tileColumns + tc].push_back(neighbour);
+          }
+        }
+      }
+    }
+
+    buffers[0].resize(totalRows, totalColumns);
+    buffers[1].resize(totalRows, totalColumns);
+  }
+
+  void play(vector<bool> &board, const int generations) {
+    buffers[0].load(board);
+    buffers[0].fillRowHalo();
+    buffers[0].fillColumnHalo();
+
+    // every tile is at generation 0, and each thread gets a contiguous block of tiles
+    completed = vector<atomic<int>>(numTiles);
+    for (int t = 0; t < numTiles; t++) completed[t].store(0);
+    queues = vector<work_queue>(numThreads);
+    for (int t = 0; t < numTiles; t++) {
+      queues[(int64_t)t * numThreads / numTiles].tiles.push_back(t);
+    }
+    remaining.store((int64_t)numTiles * generations);
+    this->generations = generations;
+
+    vector<thread> threads;
+    for (int id = 1; id < numThreads; id++) {
+      threads.push_back(thread(&ThreadedGame::work, this, id));
+    }
+    work(0);
+    for (thread &t : threads) t.join();
+
+    buffers[generations % 2].store(board);
+  }
+
+ private:
+  const int numThreads;
+  int tileRows, tileColumns, numTiles;
+  int generations;
+  vector<vector<int>> neighbours;
+  PaddedBoard buffers[2];
+  vector<atomic<int>> completed;  // the number of generations each tile has completed
+  vector<work_queue> queues;
+  atomic<int64_t> remaining;      // tile generations still to compute
+  mutex stealsLock;
+
+  // a tile can compute its next generation once all its neighbours have caught up with it
+  bool isReady(const int tile) {
+    int generation = completed[tile].load(memory_order_relaxed);
+    if (generation == generations) return false;
+    for (int neighbour : neighbours[tile]) {
+      if (completed[neighbour].load(memory_order_acquire) < generation) return false;
+    }
+    return true;
+  }
+
+  // take a ready tile out of a deque (from the back for the owner, from the front for a thief) - returns -1 if there is none
+  int takeReady(work_queue &queue, const bool fromBack) {
+    lock_guard<mutex> guard(queue.lock);
+    for (int i = 0; i < queue.tiles.size(); i++) {
+      int index = fromBack ? queue.tiles.size() - 1 - i : i;
+      int tile = queue.tiles[index];
+      if (isReady(tile)) {
+        queue.tiles.erase(queue.tiles.begin() + index);
+        return tile;
+      }
+    }
+    return -1;
+  }
+
+  void advanceTile(const int tile) {
+    const int generation = completed[tile].load(memory_order_relaxed);
+    const PaddedBoard &board = buffers[generation % 2];
+    PaddedBoard &nextGeneration = buffers[(generation + 1) % 2];
+
+    const int firstRow = (tile / tileColumns) * tileHeight;
+    const int lastRow = min(firstRow + tileHeight, totalRows);
+    const int firstColumn = (tile % tileColumns) * tileWidth;
+    const int lastColumn = min(firstColumn + tileWidth, totalColumns);
+
+    for (int row = firstRow; row < lastRow; row++) {
+      nextRowPadded(board.row(row - 1) + firstColumn, board.row(row) + firstColumn, board.row(row + 1) + firstColumn,
+                    nextGeneration.row(row) + firstColumn, lastColumn - firstColumn);
+    }
+    nextGeneration.fillHaloFrom(firstRow, lastRow, firstColumn, lastColumn);
+
+    // publish the new generation to the neighbours
+    completed[tile].store(generation + 1, memory_order_release);
+  }
+
+  void work(const int id) {
+    uint64_t stolen = 0;
+    while (remaining.load(memory_order_relaxed) > 0) {
+      int tile = takeReady(queues[id], true);
+
+      // none of our own tiles are ready - try to steal from the other threads
+      for (int i = 1; tile == -1 && i < numThreads; i++) {
+        tile = takeReady(queues[(id + i) % numThreads], false);
+        stolen += tile != -1;
+      }
+
+      if (tile == -1) {
+        this_thread::yield();
+        continue;
+      }
+
+      advanceTile(tile);
+      remaining.fetch_sub(1, memory_order_relaxed);
+
+      // the tile now belongs to us
+      if (completed[tile].load(memory_order_relaxed) < generations) {
+        lock_guard<mutex> guard(queues[id].lock);
+        queues[id].tiles.push_back(tile);
+      }
+    }
+
+    lock_guard<mutex> guard(stealsLock);
+    steals += stolen;
+  }
+};
+
+// print the cell updates per second (n/a if the run was too short to time)
+void printCellUpdateRate(const char *version, const double cellUpdates, const double seconds) {
+  if (seconds > 0) {
+    printf("%s cell updates per second: %.3e\n", version, cellUpdates / seconds);
+  } else {
+    printf("%s cell updates per second: n/a\n", version);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // check we have the arguments we need
+  if (argc < 5) {
+    printf("Usage: %s <rows> <columns> <seed> <generation> <OPTIONAL: number of threads>\n", argv[0]);
+    return 0;
+  }
+
+  // get the arguments
+  totalRows = atoi(argv[1]);
+  totalColumns = atoi(argv[2]);
+  int seed = atoi(argv[3]);
+  int generation = atoi(argv[4]);
+  int numThreads = argc > 5 ? atoi(argv[5]) : max(1, (int)thread::hardware_concurrency());
+  if (numThreads < 1) {
+    printf("Please choose at least 1 thread\n");
+    return 0;
+  }
+
+  // Create and open a text file
+  ofstream outputFile(outputFileName);
+
+  u_int64_t runTime = 0;
+  ThreadedGame game(numThreads);
+
+  for (int _ = 0; _ < averageIterations; _++) {
+    // create our board
+    vector<bool> board;
+    board.resize(totalRows * totalColumns);
+
+    // initialise the board using the seed
+    srand(seed);
+    for (int i = 0; i < board.size(); i++) {
+      bool value = ((double)rand() / RAND_MAX) >= 0.5 ? true : false;
+      board[i] = value;
+    }
+
+    // print the initial board
+    outputFile << "\n";
+    printBoard(outputFile, board);
+
+    auto startTime = chrono::high_resolution_clock::now();
+    game.play(board, generation);
+    auto endTime = chrono::high_resolution_clock::now();
+    auto duration = chrono::duration_cast<chrono::microseconds>(endTime - startTime);
+    runTime += duration.count();
+
+    // print the final board
+    outputFile << "\n";
+    printBoard(outputFile, board);
+  }
+
+  printf("Threaded average run time (%d threads): %.2fms\n", numThreads, (double)runTime / 1000 / averageIterations);
+  printCellUpdateRate("Threaded", (double)totalRows * totalColumns * generation, (double)runTime / averageIterations / 1000000);
+  printf("Threaded tiles stolen: %llu\n", (unsigned long long)game.steals);
+
+  // close the file
+  outputFile.close();
+
+  return 0;
+}